@@ -2,11 +2,11 @@
 #include "tester.h"
 
 int main(int argc, char* argv[]) {
-  if (argc != 5) {
+  if (argc != 5 && argc != 6) {
     std::cerr << "Wrong Parameter!" << std::endl;
     std::string p(argv[0]);
     std::cerr << p.substr(p.rfind('/') + 1)
-              << " <thread_num> <operation_num> <test_times> <max_key>" << std::endl;
+              << " <thread_num> <operation_num> <test_times> <max_key> [async_worker_num]" << std::endl;
     return EXIT_FAILURE;
   }
 
@@ -14,6 +14,7 @@ int main(int argc, char* argv[]) {
   std::size_t operation_num(static_cast<std::size_t>(std::stoul(argv[2])));
   std::size_t test_times(static_cast<std::size_t>(std::stoul(argv[3])));
   std::size_t max_key(static_cast<std::size_t>(std::stoul(argv[4])));
+  std::size_t async_worker_num(argc == 6 ? static_cast<std::size_t>(std::stoul(argv[5])) : 0);
 
   try {
     utils::TestThroughput thru_read("read-dominated",
@@ -29,7 +30,12 @@ int main(int argc, char* argv[]) {
                                       std::make_pair(utils::Insert, 0.5f),
                                       std::make_pair(utils::Delete, 0.5f)});
     std::vector<utils::TestThroughput> v = {thru_read, thru_mix, thru_write};
-    utils::Tester t(thread_num, operation_num, test_times, v, {0, max_key});
+    utils::Tester<utils::LockedLinkedList,
+                  utils::LazyLinkedList,
+                  utils::SegmentedLazyLinkedList,
+                  utils::LockFreeLinkedList,
+                  utils::PooledLockFreeLinkedList,
+                  utils::DeferredLockFreeLinkedList> t(thread_num, operation_num, test_times, v, {0, max_key}, async_worker_num);
     t.Test();
     debug_cout << t.ResultToString();
   } catch (...) {
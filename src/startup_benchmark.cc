@@ -0,0 +1,30 @@
+#include <cstdlib>
+#include "tester.h"
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Wrong Parameter!" << std::endl;
+    std::string p(argv[0]);
+    std::cerr << p.substr(p.rfind('/') + 1)
+              << " <max_key_num> <thread_num>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::size_t max_key_num(static_cast<std::size_t>(std::stoul(argv[1])));
+  std::size_t thread_num(static_cast<std::size_t>(std::stoul(argv[2])));
+
+  try {
+    utils::StartupTester<utils::LockedLinkedList,
+                         utils::LazyLinkedList,
+                         utils::SegmentedLazyLinkedList,
+                         utils::LockFreeLinkedList,
+                         utils::PooledLockFreeLinkedList> t(max_key_num, thread_num,
+                                                            "startup_benchmark.snapshot");
+    t.Test();
+    debug_cout << t.ResultToString();
+  } catch (...) {
+    std::cerr << "Internal Error. Test Aborted!\n";
+  }
+
+  return EXIT_SUCCESS;
+}
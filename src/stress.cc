@@ -0,0 +1,63 @@
+#include <cstdlib>
+#include "tester.h"
+
+// split and merge segments of a few keys, so the directory of a
+// SegmentedLazyLinkedList keeps changing even in a tiny key space
+struct ChurningSegmentTuning {
+  static constexpr std::size_t kSamplePeriod = 1;
+  static constexpr std::size_t kRebalancePeriod = 16;
+  static constexpr std::size_t kMinSamples = 16;
+  static constexpr std::size_t kMaxSegments = 4;
+  static constexpr std::size_t kSplitHops = 1;
+  static constexpr std::size_t kMergeHops = 2;
+  static constexpr auto name_ = "ChurningSegmentedLazyLinkedList";
+};
+
+template <typename Node>
+using ChurningSegmentDirectory = utils::BasicSegmentDirectory<Node, ChurningSegmentTuning>;
+
+template <typename Node>
+using ChurningSegmentedLazySync = utils::BasicLazySync<Node, ChurningSegmentDirectory>;
+
+typedef utils::ConcurrentSortedList<utils::SegmentListNode, ChurningSegmentedLazySync,
+                                    utils::RetireReclaim, utils::NewAlloc> ChurningSegmentedLazyLinkedList;
+
+int main(int argc, char* argv[]) {
+  if (argc < 5 || argc > 7) {
+    std::cerr << "Wrong Parameter!" << std::endl;
+    std::string p(argv[0]);
+    std::cerr << p.substr(p.rfind('/') + 1)
+              << " <thread_num> <operation_num> <round_num> <max_key> [seed] [list_name]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::size_t thread_num(static_cast<std::size_t>(std::stoul(argv[1])));
+  std::size_t operation_num(static_cast<std::size_t>(std::stoul(argv[2])));
+  std::size_t round_num(static_cast<std::size_t>(std::stoul(argv[3])));
+  int max_key(std::stoi(argv[4]));
+  // replay the round of a reported violation
+  bool replay(argc >= 6);
+  unsigned seed(replay ? static_cast<unsigned>(std::stoul(argv[5])) : 0);
+  std::string list_name(argc == 7 ? argv[6] : "");
+
+  try {
+    utils::StressTester<utils::LockedLinkedList,
+                        utils::LazyLinkedList,
+                        utils::SegmentedLazyLinkedList,
+                        ChurningSegmentedLazyLinkedList,
+                        utils::LockFreeLinkedList,
+                        utils::PooledLockFreeLinkedList,
+                        utils::DeferredLockFreeLinkedList> t(thread_num, operation_num,
+                                                             round_num, max_key,
+                                                             replay, seed, list_name);
+    std::size_t violation_num(t.Test());
+    debug_cout << t.ResultToString();
+    return violation_num ? EXIT_FAILURE : EXIT_SUCCESS;
+  } catch (const std::invalid_argument& e) {
+    std::cerr << e.what() << std::endl;
+  } catch (...) {
+    std::cerr << "Internal Error. Test Aborted!\n";
+  }
+
+  return EXIT_FAILURE;
+}
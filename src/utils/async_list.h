@@ -0,0 +1,159 @@
+#ifndef CONCURRENT_LINKED_LIST_ASYNC_LIST_H_
+#define CONCURRENT_LINKED_LIST_ASYNC_LIST_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "log_util.h"
+#include "operation.h"
+
+namespace utils {
+
+struct AsyncRequest {
+  OperationType type_;
+  int key_;
+  // exactly one of them is set
+  std::unique_ptr<std::promise<bool>> promise_;
+  std::function<void(const bool&)> callback_;
+  AsyncRequest* next_;
+  bool result_;
+};
+
+// Asynchronous front-end of a list: any thread submits requests, a fixed
+// pool of workers applies them to the list.
+// Every worker owns a lock-free stack (MPSC) of pending requests, a request
+// goes to the stack picked by its key. The worker takes its whole stack with
+// one exchange and applies it as a batch sorted by key, in one sweep of the
+// list through a finger. Requests on the same key are always applied by the
+// same worker, so they keep their submission order across batches too.
+template <typename ListType> class AsyncList {
+ public:
+  AsyncList(ListType& list, const std::size_t& worker_num)
+    : list_(list),
+      stop_(false) {
+    std::size_t lane_num(std::max<std::size_t>(1, worker_num));
+    for (std::size_t i(0); i < lane_num; ++i) {
+      lanes_.emplace_back(new Lane());
+    }
+    for (std::size_t i(0); i < lane_num; ++i) {
+      workers_.emplace_back([this, i] { this->WorkerFunc(i); });
+    }
+  }
+
+  // requests submitted before are still completed
+  ~AsyncList(void) {
+    stop_.store(true);
+    for (auto& lane : lanes_) {
+      std::lock_guard<std::mutex> guard(lane->mutex_);
+      lane->cond_.notify_one();
+    }
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  std::future<bool> Submit(const OperationType& type, const int& key) {
+    AsyncRequest* request(new AsyncRequest{type, key, nullptr, nullptr, nullptr, false});
+    request->promise_.reset(new std::promise<bool>());
+    std::future<bool> result(request->promise_->get_future());
+    Push(request);
+    return result;
+  }
+
+  // callback is called by a worker thread with the result
+  void Submit(const OperationType& type, const int& key,
+              std::function<void(const bool&)> callback) {
+    Push(new AsyncRequest{type, key, nullptr, std::move(callback), nullptr, false});
+  }
+
+ private:
+  // pending requests of one worker, the trailing padding keeps the fields of
+  // two lanes off a common cache line (a new expression does not honour
+  // alignas(64) before C++17)
+  struct Lane {
+    Lane(void)
+      : pending_(nullptr) {}
+
+    std::atomic<AsyncRequest*> pending_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    char padding_[64];
+  };
+
+  void Push(AsyncRequest* request) {
+    Lane& lane(*lanes_.at(static_cast<unsigned>(request->key_) % lanes_.size()));
+    AsyncRequest* head(lane.pending_.load());
+    do {
+      request->next_ = head;
+    } while (!std::atomic_compare_exchange_weak(&lane.pending_, &head, request));
+
+    // only wake the worker on the transition from empty
+    if (!head) {
+      std::lock_guard<std::mutex> guard(lane.mutex_);
+      lane.cond_.notify_one();
+    }
+  }
+
+  void WorkerFunc(const std::size_t& id) {
+    Lane& lane(*lanes_.at(id));
+    std::vector<AsyncRequest*> batch;
+    while (true) {
+      AsyncRequest* head(lane.pending_.exchange(nullptr));
+      if (!head) {
+        std::unique_lock<std::mutex> lock(lane.mutex_);
+        lane.cond_.wait(lock, [this, &lane] { return stop_.load() || lane.pending_.load(); });
+        if (stop_.load() && !lane.pending_.load()) {
+          return;
+        }
+        continue;
+      }
+
+      // the stack is in reverse submission order
+      for (; head; head = head->next_) {
+        batch.push_back(head);
+      }
+      std::reverse(batch.begin(), batch.end());
+      std::stable_sort(batch.begin(), batch.end(),
+                       [](const AsyncRequest* a, const AsyncRequest* b) {
+                         return a->key_ < b->key_;
+                       });
+
+      debug_clog << "[worker " << id << "] " << ListType::name_
+                 << " batch of " << batch.size() << "\n";
+
+      // results are only delivered once the finger is released, a finger
+      // of LockedLinkedList holds the list lock
+      {
+        typename ListType::Finger finger;
+        for (auto request : batch) {
+          request->result_ = Apply(list_, request->type_, request->key_, finger);
+        }
+      }
+      for (auto request : batch) {
+        if (request->callback_) {
+          request->callback_(request->result_);
+        } else {
+          request->promise_->set_value(request->result_);
+        }
+        delete request;
+      }
+      batch.clear();
+    }
+  }
+
+  ListType& list_;
+  std::vector<std::unique_ptr<Lane>> lanes_;
+  std::atomic<bool> stop_;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace utils
+
+#endif // CONCURRENT_LINKED_LIST_ASYNC_LIST_H_
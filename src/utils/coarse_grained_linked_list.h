@@ -1,43 +1,51 @@
 #ifndef CONCURRENT_LINKED_LIST_COARSE_GRAINED_LINKED_LIST_H_
 #define CONCURRENT_LINKED_LIST_COARSE_GRAINED_LINKED_LIST_H_
 
-#include <limits>
 #include <mutex>
-#include <sstream>
+#include "concurrent_sorted_list.h"
 #include "list_node.h"
-#include "log_util.h"
 
 namespace utils {
 
-class LockedLinkedList {
+// Sync policy: one mutex for all updates, search is oblivious to locks
+template <typename Node> class CoarseSync {
  public:
-  LockedLinkedList(void)
-    : head_(std::numeric_limits<int>::min(), &tail_),
-      tail_(std::numeric_limits<int>::max(), nullptr) {}
-
-  ~LockedLinkedList() {
-    ListNode* curr(head_.next_);
-    ListNode* tmp(nullptr);
-    while (curr != &tail_) {
-      tmp = curr;
-      curr = curr->next_;
-      debug_clog << "~LockedLinkedList free " << tmp->val_ << std::endl;
-      delete tmp;
+  // a batch holds the update lock from its first operation to its end, so
+  // every traversal resumes from the pred of the previous one
+  struct Finger {
+    Finger(void)
+      : pred_(nullptr) {}
+
+    std::unique_lock<std::mutex> lock_;
+    Node* pred_;
+  };
+
+  static Node* Next(Node* node) { return node->next_; }
+
+  static bool IsDeleted(Node*) { return false; }
+
+  template <typename ListType> void Rebuild(ListType&) {}
+
+  // hold the update lock for the whole traversal
+  template <typename ListType, typename Visitor> void Snapshot(ListType& list, Visitor visit) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (Node* curr(list.head_.next_); curr != &list.tail_; curr = curr->next_) {
+      visit(curr->val_);
     }
   }
 
-  bool Search(const int& value) {
-    ListNode* curr(head_.next_);
+  template <typename ListType> bool Search(ListType& list, const int& value) {
+    Node* curr(list.head_.next_);
     while (curr && curr->val_ < value) {
       curr = curr->next_;
     }
     return (curr && curr->val_ == value);
   }
 
-  bool Insert(const int& value) {
+  template <typename ListType> bool Insert(ListType& list, const int& value) {
     std::lock_guard<std::mutex> guard(mutex_);
-    ListNode* pred(&head_);
-    ListNode* curr(head_.next_);
+    Node* pred(&list.head_);
+    Node* curr(list.head_.next_);
     while (curr->val_ < value) {
       pred = pred->next_;
       curr = curr->next_;
@@ -45,50 +53,80 @@ class LockedLinkedList {
     if (curr->val_ == value) {
       return false;
     } else {
-      pred->next_ = new ListNode(value, curr);
+      pred->next_ = list.alloc_.Create(value, curr);
       return true;
     }
   }
 
-  bool Delete(const int& value) {
+  template <typename ListType> bool Delete(ListType& list, const int& value) {
     std::lock_guard<std::mutex> guard(mutex_);
-    ListNode* pred(&head_);
-    ListNode* curr(head_.next_);
+    Node* pred(&list.head_);
+    Node* curr(list.head_.next_);
     while (curr->val_ < value) {
       pred = pred->next_;
       curr = curr->next_;
     }
     if (curr->val_ == value) {
       pred->next_ = curr->next_;
-      delete curr;
+      list.reclaim_.Retire(curr, list.alloc_);
       return true;
     } else {
       return false;
     }
   }
 
-  std::string ToString(void) {
-    std::stringstream ss;
-    ListNode* curr(head_.next_);
-    while (curr != &tail_) {
-      ss << curr->val_;
-      if (curr->next_ != &tail_) {
-        ss << " ";
-      }
-      curr = curr->next_;
+  template <typename ListType> bool Search(ListType& list, const int& value, Finger& finger) {
+    return (Seek(list, value, finger)->next_->val_ == value);
+  }
+
+  template <typename ListType> bool Insert(ListType& list, const int& value, Finger& finger) {
+    Node* pred(Seek(list, value, finger));
+    Node* curr(pred->next_);
+    if (curr->val_ == value) {
+      return false;
+    }
+    pred->next_ = list.alloc_.Create(value, curr);
+    return true;
+  }
+
+  template <typename ListType> bool Delete(ListType& list, const int& value, Finger& finger) {
+    Node* pred(Seek(list, value, finger));
+    Node* curr(pred->next_);
+    if (curr->val_ != value) {
+      return false;
     }
-    return ss.str();
+    pred->next_ = curr->next_;
+    list.reclaim_.Retire(curr, list.alloc_);
+    return true;
   }
 
  private:
+  // return the last node whose value is less than key, the first call of a
+  // batch takes the lock
+  template <typename ListType> Node* Seek(ListType& list, const int& key, Finger& finger) {
+    if (!finger.lock_.owns_lock()) {
+      finger.lock_ = std::unique_lock<std::mutex>(mutex_);
+      finger.pred_ = &list.head_;
+    }
+    // keys out of order start over
+    if (finger.pred_->val_ >= key) {
+      finger.pred_ = &list.head_;
+    }
+    while (finger.pred_->next_->val_ < key) {
+      finger.pred_ = finger.pred_->next_;
+    }
+    return finger.pred_;
+  }
+
   std::mutex mutex_;
-  ListNode head_;
-  ListNode tail_;
 
  public:
   static constexpr auto name_ = "LockedLinkedList";
 };
 
+// searches run without the lock, so unlinked nodes are retired, not freed
+typedef ConcurrentSortedList<ListNode, CoarseSync, RetireReclaim, NewAlloc> LockedLinkedList;
+
 } // namespace utils
 
 #endif // CONCURRENT_LINKED_LIST_COARSE_GRAINED_LINKED_LIST_H_
@@ -0,0 +1,463 @@
+#ifndef CONCURRENT_LINKED_LIST_CONCURRENT_SORTED_LIST_H_
+#define CONCURRENT_LINKED_LIST_CONCURRENT_SORTED_LIST_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "list_node.h"
+#include "log_util.h"
+
+namespace utils {
+
+// link a node for each distinct value of the sorted range [begin, end)
+// return <first, last> of the chain, last->next_ is left as nullptr
+template <typename Node, typename Iterator, typename Factory>
+std::pair<Node*, Node*> LinkSortedChain(Iterator begin, Iterator end, Factory create) {
+  Node* first(nullptr);
+  Node* last(nullptr);
+  for (; begin != end; ++begin) {
+    if (last && last->val_ == *begin) {
+      continue;
+    }
+    Node* node(create(*begin));
+    if (last) {
+      last->next_ = node;
+    } else {
+      first = node;
+    }
+    last = node;
+  }
+  return std::make_pair(first, last);
+}
+
+// Alloc policy: plain new / delete
+template <typename Node> class NewAlloc {
+ public:
+  template <typename... Args> Node* Create(Args&&... args) {
+    return new Node(std::forward<Args>(args)...);
+  }
+
+  void Destroy(Node* node) { delete node; }
+
+  template <typename Iterator>
+  std::pair<Node*, Node*> CreateChain(Iterator begin, Iterator end) {
+    return LinkSortedChain<Node>(begin, end, [this](const int& value) {
+      return Create(value, nullptr);
+    });
+  }
+
+  // take over the nodes allocated by another allocator
+  void Adopt(NewAlloc&) {}
+
+  static constexpr auto prefix_ = "";
+};
+
+// Alloc policy: nodes are carved from blocks which are only released when
+// the allocator is destroyed, a destroyed node is not recycled (the lists
+// retire unlinked nodes until they are destroyed anyway).
+// Create takes a slot of the shared current block with one fetch_add, the
+// mutex is only taken to chain a new block. Each CreateChain call carves
+// its chain from a private block, so bulk-build workers never contend.
+template <typename Node> class PoolAlloc {
+ public:
+  PoolAlloc(void)
+    : current_(nullptr) {}
+
+  template <typename... Args> Node* Create(Args&&... args) {
+    while (true) {
+      Block* block(current_.load(std::memory_order_acquire));
+      if (block) {
+        std::size_t index(block->used_.fetch_add(1, std::memory_order_relaxed));
+        if (index < kBlockSize) {
+          return new (&block->slots_[index]) Node(std::forward<Args>(args)...);
+        }
+      }
+      Refill(block);
+    }
+  }
+
+  void Destroy(Node* node) { node->~Node(); }
+
+  // the whole chain lives in one contiguous block, in key order
+  template <typename Iterator>
+  std::pair<Node*, Node*> CreateChain(Iterator begin, Iterator end) {
+    std::size_t count(std::distance(begin, end));
+    if (!count) {
+      return std::make_pair(nullptr, nullptr);
+    }
+    Slot* chain(new Slot[count]);
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      chains_.emplace_back(chain);
+    }
+    std::size_t used(0);
+    return LinkSortedChain<Node>(begin, end, [chain, &used](const int& value) {
+      return new (&chain[used++]) Node(value, nullptr);
+    });
+  }
+
+  // take over the nodes allocated by another allocator
+  void Adopt(PoolAlloc& other) {
+    std::lock(mutex_, other.mutex_);
+    std::lock_guard<std::mutex> guard(mutex_, std::adopt_lock);
+    std::lock_guard<std::mutex> other_guard(other.mutex_, std::adopt_lock);
+    std::move(other.blocks_.begin(), other.blocks_.end(), std::back_inserter(blocks_));
+    std::move(other.chains_.begin(), other.chains_.end(), std::back_inserter(chains_));
+    other.blocks_.clear();
+    other.chains_.clear();
+    other.current_.store(nullptr);
+  }
+
+  static constexpr auto prefix_ = "Pooled";
+
+ private:
+  typedef typename std::aligned_storage<sizeof(Node), alignof(Node)>::type Slot;
+
+  static constexpr std::size_t kBlockSize = 1024;
+
+  struct Block {
+    Block(void)
+      : used_(0) {}
+
+    // may run past kBlockSize, every index from there on is refused
+    std::atomic<std::size_t> used_;
+    Slot slots_[kBlockSize];
+  };
+
+  // publish a new block unless another thread already replaced full
+  void Refill(Block* full) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (current_.load() == full) {
+      blocks_.emplace_back(new Block());
+      current_.store(blocks_.back().get(), std::memory_order_release);
+    }
+  }
+
+  std::atomic<Block*> current_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Block>> blocks_;
+  std::vector<std::unique_ptr<Slot[]>> chains_;
+};
+
+// Reclaim policy: keep unlinked nodes until the list is destroyed
+// every search traverses without a lock, so no node can be freed earlier
+// Retiring takes no lock: a thread appends to its own chunk, which is pushed
+// onto a lock-free stack once when the thread starts it. A run of unlinked
+// nodes is recorded as one entry and walked when the list is drained.
+template <typename Node> class RetireReclaim {
+ public:
+  RetireReclaim(void)
+    : id_(NextId()),
+      chunks_(nullptr) {}
+
+  ~RetireReclaim(void) {
+    Chunk* chunk(chunks_.load());
+    while (chunk) {
+      Chunk* next(chunk->next_);
+      delete chunk;
+      chunk = next;
+    }
+  }
+
+  template <typename Alloc> void Retire(Node* node, Alloc&) {
+    Record(node, nullptr);
+  }
+
+  // retire the unlinked run [first, last), its links must be frozen
+  template <typename Alloc> void RetireRun(Node* first, Node* last, Alloc&) {
+    if (first != last) {
+      Record(first, last);
+    }
+  }
+
+  // destroy every retired node, next(node) follows a link inside a run
+  // only call it when no other thread uses the list
+  template <typename Alloc, typename Next> void Drain(Alloc& alloc, Next next) {
+    Chunk* chunk(chunks_.exchange(nullptr));
+    while (chunk) {
+      for (std::size_t i(0); i < chunk->size_; ++i) {
+        Node* first(chunk->runs_[i].first);
+        Node* last(chunk->runs_[i].second);
+        do {
+          Node* tmp(first);
+          first = next(first);
+          alloc.Destroy(tmp);
+        } while (last && first != last);
+      }
+      Chunk* tmp(chunk);
+      chunk = chunk->next_;
+      delete tmp;
+    }
+    // chunks cached by threads are gone
+    id_ = NextId();
+  }
+
+ private:
+  static constexpr std::size_t kChunkSize = 256;
+
+  struct Chunk {
+    // runs_[i].second == nullptr: a single node
+    std::pair<Node*, Node*> runs_[kChunkSize];
+    std::size_t size_;
+    Chunk* next_;
+  };
+
+  // identifies a reclaimer over its lifetime, unlike its address
+  static std::size_t NextId(void) {
+    static std::atomic<std::size_t> next_id(1);
+    return next_id.fetch_add(1);
+  }
+
+  void Record(Node* first, Node* last) {
+    // the chunk a thread appends to, and the reclaimer owning it; a thread
+    // alternating between lists starts a new chunk at every switch
+    static thread_local std::size_t owner(0);
+    static thread_local Chunk* local(nullptr);
+    if (owner != id_ || local->size_ == kChunkSize) {
+      local = new Chunk;
+      local->size_ = 0;
+      local->next_ = chunks_.load();
+      while (!chunks_.compare_exchange_weak(local->next_, local)) {}
+      owner = id_;
+    }
+    local->runs_[local->size_++] = std::make_pair(first, last);
+  }
+
+  std::size_t id_;
+  std::atomic<Chunk*> chunks_;
+};
+
+// Sorted set of int built from four policies:
+//   Node:    node layout (ListNode, LockedListNode, AtomicListNode)
+//   Sync:    synchronization algorithm, provides Search / Insert / Delete
+//            (also with a Finger for sorted batches), the traversal
+//            primitives Next / IsDeleted and Rebuild, called
+//            after a bulk operation relinked the nodes
+//   Reclaim: what happens to a node after it is unlinked
+//   Alloc:   how nodes are created and destroyed
+template <typename Node,
+          template <typename> class Sync,
+          template <typename> class Reclaim,
+          template <typename> class Alloc>
+class ConcurrentSortedList {
+ public:
+  typedef Node NodeType;
+  typedef Sync<Node> SyncType;
+  typedef typename SyncType::Finger Finger;
+
+  ConcurrentSortedList(void)
+    : head_(std::numeric_limits<int>::min(), &tail_),
+      tail_(std::numeric_limits<int>::max(), nullptr) {}
+
+  // bulk-build from the sorted range [begin, end)
+  template <typename Iterator>
+  ConcurrentSortedList(Iterator begin, Iterator end, const std::size_t& thread_num = 1)
+    : head_(std::numeric_limits<int>::min(), &tail_),
+      tail_(std::numeric_limits<int>::max(), nullptr) {
+    BuildFromSorted(begin, end, thread_num);
+  }
+
+  ~ConcurrentSortedList(void) {
+    Node* curr(SyncType::Next(&head_));
+    Node* tmp(nullptr);
+    while (curr != &tail_) {
+      tmp = curr;
+      curr = SyncType::Next(curr);
+      debug_clog << "~" << name_ << " free " << tmp->val_ << std::endl;
+      alloc_.Destroy(tmp);
+    }
+    reclaim_.Drain(alloc_, &SyncType::Next);
+  }
+
+  bool Search(const int& value) { return sync_.Search(*this, value); }
+
+  bool Insert(const int& value) { return sync_.Insert(*this, value); }
+
+  bool Delete(const int& value) { return sync_.Delete(*this, value); }
+
+  // batch variants: the finger keeps the window of the previous operation,
+  // so a batch sorted by key is served in about one traversal
+  bool Search(const int& value, Finger& finger) { return sync_.Search(*this, value, finger); }
+
+  bool Insert(const int& value, Finger& finger) { return sync_.Insert(*this, value, finger); }
+
+  bool Delete(const int& value, Finger& finger) { return sync_.Delete(*this, value, finger); }
+
+  // Bulk operations below must not run concurrently with any other operation
+  // on the lists involved.
+
+  // add every value of the sorted range [begin, end), thread_num workers
+  // each build a disjoint segment, the segments are then spliced together
+  // and merged into the list in linear time
+  template <typename Iterator>
+  void BuildFromSorted(Iterator begin, Iterator end, const std::size_t& thread_num = 1) {
+    std::size_t count(std::distance(begin, end));
+    std::size_t worker_num(std::max<std::size_t>(1, std::min(thread_num, count)));
+    std::vector<std::pair<Node*, Node*>> segments(worker_num);
+    std::vector<std::thread> workers;
+
+    std::size_t per_worker(count / worker_num);
+    Iterator segment_begin(begin);
+    for (std::size_t i(0); i < worker_num; ++i) {
+      Iterator segment_end(segment_begin);
+      std::advance(segment_end, (i + 1 == worker_num) ? count - per_worker * i : per_worker);
+      if (i + 1 == worker_num) {
+        segments.at(i) = alloc_.CreateChain(segment_begin, segment_end);
+      } else {
+        workers.emplace_back([this, &segments, i, segment_begin, segment_end] {
+          segments.at(i) = alloc_.CreateChain(segment_begin, segment_end);
+        });
+      }
+      segment_begin = segment_end;
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    // splice segments, a value may be repeated across a segment boundary
+    Node* first(nullptr);
+    Node* last(nullptr);
+    for (auto& segment : segments) {
+      Node* curr(segment.first);
+      while (curr && last && curr->val_ <= last->val_) {
+        Node* tmp(curr);
+        curr = (curr == segment.second) ? nullptr : SyncType::Next(curr);
+        alloc_.Destroy(tmp);
+      }
+      if (!curr) {
+        continue;
+      }
+      if (last) {
+        last->next_ = curr;
+      } else {
+        first = curr;
+      }
+      last = segment.second;
+    }
+
+    if (last) {
+      last->next_ = nullptr;
+      MergeChain(first, nullptr);
+      sync_.Rebuild(*this);
+    }
+  }
+
+  // move every node of other into this list in linear time, other is empty
+  // afterwards
+  void Merge(ConcurrentSortedList& other) {
+    if (&other == this) {
+      return;
+    }
+    other.reclaim_.Drain(other.alloc_, &SyncType::Next);
+    alloc_.Adopt(other.alloc_);
+    Node* first(SyncType::Next(&other.head_));
+    other.head_.next_ = &other.tail_;
+    MergeChain(first, &other.tail_);
+    sync_.Rebuild(*this);
+    other.sync_.Rebuild(other);
+  }
+
+  // call visit(value) for each value of one state of the list, in ascending
+  // order, while updates may run concurrently
+  // only provided by Sync policies which can hold updates off
+  template <typename Visitor> void Snapshot(Visitor visit) { sync_.Snapshot(*this, visit); }
+
+  // call visit(value) for each value in ascending order
+  // only a consistent snapshot if no update runs concurrently
+  template <typename Visitor> void ForEach(Visitor visit) {
+    Node* curr(SyncType::Next(&head_));
+    while (curr != &tail_) {
+      // skip nodes which are logically deleted but still linked
+      if (!SyncType::IsDeleted(curr)) {
+        visit(curr->val_);
+      }
+      curr = SyncType::Next(curr);
+    }
+  }
+
+  std::string ToString(void) {
+    std::stringstream ss;
+    bool first(true);
+    ForEach([&ss, &first](const int& value) {
+      if (!first) {
+        ss << " ";
+      }
+      ss << value;
+      first = false;
+    });
+    return ss.str();
+  }
+
+ private:
+  friend SyncType;
+
+  // merge the sorted chain [first, end) into the list, duplicated and
+  // logically deleted nodes are destroyed
+  void MergeChain(Node* first, Node* const end) {
+    Node* pred(&head_);
+    Node* curr(SyncType::Next(&head_));
+    while (first != end || curr != &tail_) {
+      if (curr != &tail_ && SyncType::IsDeleted(curr)) {
+        Node* tmp(curr);
+        curr = SyncType::Next(curr);
+        alloc_.Destroy(tmp);
+        continue;
+      }
+      if (first != end && SyncType::IsDeleted(first)) {
+        Node* tmp(first);
+        first = SyncType::Next(first);
+        alloc_.Destroy(tmp);
+        continue;
+      }
+
+      Node* next(nullptr);
+      if (first == end || (curr != &tail_ && curr->val_ <= first->val_)) {
+        if (first != end && curr->val_ == first->val_) {
+          Node* tmp(first);
+          first = SyncType::Next(first);
+          alloc_.Destroy(tmp);
+        }
+        next = curr;
+        curr = SyncType::Next(curr);
+      } else {
+        next = first;
+        first = SyncType::Next(first);
+      }
+      pred->next_ = next;
+      pred = next;
+    }
+    pred->next_ = &tail_;
+  }
+
+  Node head_;
+  Node tail_;
+  SyncType sync_;
+  Alloc<Node> alloc_;
+  Reclaim<Node> reclaim_;
+
+ public:
+  // the Sync policy names the algorithm, the Alloc policy may prefix it
+  static const std::string name_;
+};
+
+template <typename Node,
+          template <typename> class Sync,
+          template <typename> class Reclaim,
+          template <typename> class Alloc>
+const std::string ConcurrentSortedList<Node, Sync, Reclaim, Alloc>::name_ =
+    std::string(Alloc<Node>::prefix_) + Sync<Node>::name_;
+
+} // namespace utils
+
+#endif // CONCURRENT_LINKED_LIST_CONCURRENT_SORTED_LIST_H_
@@ -1,54 +1,132 @@
 #ifndef CONCURRENT_LINKED_LIST_FINE_GRAINED_LINKED_LIST_H_
 #define CONCURRENT_LINKED_LIST_FINE_GRAINED_LINKED_LIST_H_
 
-#include <limits>
-#include <mutex>
-#include <sstream>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "concurrent_sorted_list.h"
 #include "list_node.h"
 
 namespace utils {
 
-class LazyLinkedList {
+// Entry policy of BasicLazySync: every traversal starts from head_
+template <typename Node> class HeadEntry {
  public:
-  LazyLinkedList(void)
-      : head_(std::numeric_limits<int>::min(), &tail_, false),
-        tail_(std::numeric_limits<int>::max(), nullptr, false) {}
-
-  ~LazyLinkedList() {
-    LockedListNode* curr(head_.next_);
-    LockedListNode* tmp(nullptr);
-    while (curr != &tail_) {
-      tmp = curr;
-      curr = curr->next_;
-      debug_clog << "~LazyLinkedList free " << tmp->val_ << std::endl;
-      delete tmp;
+  struct Ticket {};
+
+  static bool IsSentinel(Node*) { return false; }
+
+  // whether a traversal for key must move past node
+  static bool Before(Node* node, const int& key) { return node->val_ < key; }
+
+  Node* Enter(Node* head, const int&, Ticket&) { return head; }
+
+  void Leave(const Ticket&, const std::size_t&) {}
+
+  template <typename Alloc> void Maintain(Node*, Alloc&) {}
+
+  void Rebuild(Node*) {}
+
+  static constexpr auto name_ = "LazyLinkedList";
+};
+
+// Sync policy: lazy synchronization, lock the window and validate it
+// the Entry policy chooses the node a traversal starts from and is told its
+// length, searches take no lock, only updates let it reorganize
+template <typename Node, template <typename> class Entry> class BasicLazySync {
+ public:
+  typedef std::pair<Node*, Node*> Window;
+  typedef typename Entry<Node>::Ticket Ticket;
+
+  // pred of the previous window of a batch, a traversal resumes from it
+  // while it is unmarked, hence still in the list
+  struct Finger {
+    Finger(void)
+      : pred_(nullptr) {}
+
+    Node* pred_;
+  };
+
+  static Node* Next(Node* node) { return node->next_; }
+
+  static bool IsDeleted(Node* node) { return node->marked_ || Entry<Node>::IsSentinel(node); }
+
+  template <typename ListType> void Rebuild(ListType& list) { entry_.Rebuild(&list.head_); }
+
+  // lock every node from head_ to tail_ in list order and keep the locks
+  // a node reached from a locked pred can neither be unlinked nor get a new
+  // predecessor, so the values visited are the state of the list once tail_
+  // is locked; searches go on, updates wait until the traversal is over
+  template <typename ListType, typename Visitor> void Snapshot(ListType& list, Visitor visit) {
+    std::vector<Node*> locked;
+    try {
+      Node* curr(&list.head_);
+      curr->Lock();
+      locked.push_back(curr);
+      while (curr != &list.tail_) {
+        curr = curr->next_;
+        curr->Lock();
+        locked.push_back(curr);
+        if (curr != &list.tail_ && !IsDeleted(curr)) {
+          visit(curr->val_);
+        }
+      }
+    } catch (...) {
+      Unlock(locked);
+      throw;
     }
+    Unlock(locked);
   }
 
-  bool Search(const int& value) {
-    LockedListNode* curr(head_.next_);
-    while (curr && curr->val_ < value) {
-      curr = curr->next_;
-    }
-    return (curr && curr->val_ == value && !curr->marked_);
+  template <typename ListType> bool Search(ListType& list, const int& value) {
+    Finger finger;
+    return Search(list, value, finger);
+  }
+
+  template <typename ListType> bool Insert(ListType& list, const int& value) {
+    Finger finger;
+    return Insert(list, value, finger);
+  }
+
+  template <typename ListType> bool Delete(ListType& list, const int& value) {
+    Finger finger;
+    return Delete(list, value, finger);
   }
 
-  bool Insert(const int& value) {
+  template <typename ListType> bool Search(ListType& list, const int& value, Finger& finger) {
+    Node* curr(LocateWindow(list, value, finger).second);
+    return (curr->val_ == value && !curr->marked_);
+  }
+
+  template <typename ListType> bool Insert(ListType& list, const int& value, Finger& finger) {
+    bool ret(InsertLocked(list, value, finger));
+    entry_.Maintain(&list.tail_, list.alloc_);
+    return ret;
+  }
+
+  template <typename ListType> bool Delete(ListType& list, const int& value, Finger& finger) {
+    bool ret(DeleteLocked(list, value, finger));
+    entry_.Maintain(&list.tail_, list.alloc_);
+    return ret;
+  }
+
+ private:
+  template <typename ListType> bool InsertLocked(ListType& list, const int& value, Finger& finger) {
     while(true) {
       // find a window
-      LockedListWindow scan_window(LocateWindow(value));
+      Window scan_window(LocateWindow(list, value, finger));
 
       // lock the window
-      WindowGuard<LockedListWindow> guard(scan_window);
+      WindowGuard<Window> guard(scan_window);
 
       // validate the window
       if (Validate(scan_window)) {
-        LockedListNode *pred(scan_window.first);
-        LockedListNode *curr(scan_window.second);
+        Node *pred(scan_window.first);
+        Node *curr(scan_window.second);
         if (curr->val_ == value) {
           return false;
         } else {
-          pred->next_ = new LockedListNode(value, curr, false);
+          pred->next_ = list.alloc_.Create(value, curr);
           return true;
         }
       }
@@ -56,25 +134,24 @@ class LazyLinkedList {
     }
   }
 
-  bool Delete(const int& value) {
+  template <typename ListType> bool DeleteLocked(ListType& list, const int& value, Finger& finger) {
     while(true) {
       // find a window
-      LockedListWindow scan_window(LocateWindow(value));
+      Window scan_window(LocateWindow(list, value, finger));
 
       // lock the window
-      WindowGuard<LockedListWindow> guard(scan_window);
+      WindowGuard<Window> guard(scan_window);
 
       // validate the window
       if (Validate(scan_window)) {
-        LockedListNode *pred(scan_window.first);
-        LockedListNode *curr(scan_window.second);
+        Node *pred(scan_window.first);
+        Node *curr(scan_window.second);
         if (curr->val_ != value) {
           return false;
         } else {
           curr->marked_ = true;
           pred->next_ = curr->next_;
-          // TODO: find a way to delete it
-          // delete curr;
+          list.reclaim_.Retire(curr, list.alloc_);
           return true;
         }
       }
@@ -82,43 +159,48 @@ class LazyLinkedList {
     }
   }
 
-  std::string ToString(void) {
-    std::stringstream ss;
-    LockedListNode* curr(head_.next_);
-    while (curr != &tail_) {
-      ss << curr->val_;
-      if (curr->next_ != &tail_) {
-        ss << " ";
-      }
-      curr = curr->next_;
+  template <typename ListType> Window LocateWindow(ListType& list, const int& key, Finger& finger) {
+    Ticket ticket;
+    Node* pred(entry_.Enter(&list.head_, key, ticket));
+    // resume from the finger if it is further on
+    Node* hint(finger.pred_);
+    if (hint && !hint->marked_ && Entry<Node>::Before(hint, key) && pred->val_ < hint->val_) {
+      pred = hint;
     }
-    return ss.str();
-  }
-
- private:
-  LockedListNode head_;
-  LockedListNode tail_;
-
-  LockedListWindow LocateWindow(const int& key) {
-    LockedListNode* pred(&head_);
-    LockedListNode* curr(head_.next_);
-    while (curr->val_ < key) {
+    Node* curr(pred->next_);
+    std::size_t hops(0);
+    while (Entry<Node>::Before(curr, key)) {
       pred = curr;
       curr = curr->next_;
+      ++hops;
     }
+    entry_.Leave(ticket, hops);
+    finger.pred_ = pred;
     return std::make_pair(pred, curr);
   }
 
-  bool Validate(const LockedListWindow& window) const {
-    LockedListNode* pred(window.first);
-    LockedListNode* curr(window.second);
+  static void Unlock(const std::vector<Node*>& locked) {
+    for (auto node(locked.rbegin()); node != locked.rend(); ++node) {
+      (*node)->Unlock();
+    }
+  }
+
+  bool Validate(const Window& window) const {
+    Node* pred(window.first);
+    Node* curr(window.second);
     return (!pred->marked_ && !curr->marked_ && pred->next_ == curr);
   }
 
+  Entry<Node> entry_;
+
  public:
-  static constexpr auto name_ = "LazyLinkedList";
+  static constexpr auto name_ = Entry<Node>::name_;
 };
 
+template <typename Node> using LazySync = BasicLazySync<Node, HeadEntry>;
+
+typedef ConcurrentSortedList<LockedListNode, LazySync, RetireReclaim, NewAlloc> LazyLinkedList;
+
 } // namespace utils
 
 #endif // CONCURRENT_LINKED_LIST_FINE_GRAINED_LINKED_LIST_H_
@@ -0,0 +1,93 @@
+#ifndef CONCURRENT_LINKED_LIST_HISTORY_H_
+#define CONCURRENT_LINKED_LIST_HISTORY_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "operation.h"
+
+namespace utils {
+
+struct HistoryEvent {
+  OperationType type_;
+  int key_;
+  bool result_;
+  std::size_t thread_;
+  // steady clock, nanoseconds
+  int64_t invoke_;
+  int64_t response_;
+};
+
+typedef std::vector<HistoryEvent> History;
+
+inline std::string EventToString(const HistoryEvent& event, const int64_t& origin = 0) {
+  std::stringstream ss;
+  ss << "[thread " << event.thread_ << "] ";
+  if (Search == event.type_) {
+    ss << "Search";
+  } else if (Insert == event.type_) {
+    ss << "Insert";
+  } else {
+    ss << "Delete";
+  }
+  ss << "(" << event.key_ << ") = " << std::boolalpha << event.result_
+     << " @ [" << event.invoke_ - origin << ", " << event.response_ - origin << "] (ns)";
+  return ss.str();
+}
+
+// Records the operations of a concurrent run. Each thread only appends to its
+// own preallocated buffer, so recording takes no lock and shares no cache
+// line on the hot path.
+class HistoryRecorder {
+ public:
+  HistoryRecorder(const std::size_t& thread_num, const std::size_t& reserve_per_thread)
+    : buffers_(thread_num) {
+    for (auto& buffer : buffers_) {
+      buffer.events_.reserve(reserve_per_thread);
+    }
+  }
+
+  static int64_t Now(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // apply one operation to list and record it for thread id
+  template <typename ListType>
+  bool Invoke(ListType& list, const std::size_t& id, const OperationType& type, const int& key) {
+    int64_t invoke(Now());
+    bool ret(Apply(list, type, key));
+    buffers_.at(id).events_.push_back({type, key, ret, id, invoke, Now()});
+    return ret;
+  }
+
+  // merge all buffers ordered by invocation, only call after threads joined
+  History Collect(void) const {
+    History history;
+    for (auto& buffer : buffers_) {
+      history.insert(history.end(), buffer.events_.begin(), buffer.events_.end());
+    }
+    std::sort(history.begin(), history.end(),
+              [](const HistoryEvent& a, const HistoryEvent& b) {
+                return a.invoke_ < b.invoke_;
+              });
+    return history;
+  }
+
+ private:
+  // keep buffers of different threads on different cache lines
+  struct Buffer {
+    History events_;
+    char padding_[64];
+  };
+
+  std::vector<Buffer> buffers_;
+};
+
+} // namespace utils
+
+#endif // CONCURRENT_LINKED_LIST_HISTORY_H_
@@ -0,0 +1,188 @@
+#ifndef CONCURRENT_LINKED_LIST_LINEARIZABILITY_CHECKER_H_
+#define CONCURRENT_LINKED_LIST_LINEARIZABILITY_CHECKER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "history.h"
+#include "operation.h"
+
+namespace utils {
+
+// a single key whose operations cannot be linearized, events_ is the
+// shortest independent segment of its history showing it
+struct Violation {
+  int key_;
+  bool absent_possible_;
+  bool present_possible_;
+  History events_;
+
+  std::string ToString(void) const {
+    std::stringstream ss;
+    ss << "key " << key_ << " is not linearizable, "
+       << events_.size() << " operation(s) starting with the key "
+       << (absent_possible_ && present_possible_ ? "absent or present"
+           : (present_possible_ ? "present" : "absent"))
+       << ":\n";
+    for (auto& event : events_) {
+      ss << "  " << EventToString(event, events_.front().invoke_) << "\n";
+    }
+    return ss.str();
+  }
+};
+
+// Offline linearizability checker for set semantics.
+// A set of int is the product of one boolean register per key, and
+// linearizability is local, so every key is checked on its own. The history
+// of a key is further cut at quiescent points (every earlier operation has
+// responded before the next one is invoked), and each segment is searched
+// with a memoized Wing & Gong style backtracking over the possible states.
+class LinearizabilityChecker {
+ public:
+  // initial: keys present before the history starts
+  explicit LinearizabilityChecker(const std::vector<int>& initial = std::vector<int>())
+    : initial_(initial.begin(), initial.end()) {}
+
+  // return one violation per failing key, empty if the history is linearizable
+  std::vector<Violation> Check(const History& history) const {
+    std::map<int, History> key_histories;
+    for (auto& event : history) {
+      key_histories[event.key_].push_back(event);
+    }
+
+    std::vector<Violation> violations;
+    for (auto& key_history : key_histories) {
+      History& events(key_history.second);
+      std::stable_sort(events.begin(), events.end(),
+                       [](const HistoryEvent& a, const HistoryEvent& b) {
+                         return a.invoke_ < b.invoke_;
+                       });
+
+      // bit 0: the key may be absent, bit 1: the key may be present
+      unsigned states(initial_.count(key_history.first) ? 2 : 1);
+      std::size_t begin(0);
+      while (begin < events.size()) {
+        // cut at the next quiescent point
+        std::size_t end(begin + 1);
+        int64_t max_response(events.at(begin).response_);
+        while (end < events.size() && events.at(end).invoke_ <= max_response) {
+          max_response = std::max(max_response, events.at(end).response_);
+          ++end;
+        }
+
+        History segment(events.begin() + begin, events.begin() + end);
+        unsigned end_states(0);
+        for (unsigned state(0); state < 2; ++state) {
+          if (states & (1u << state)) {
+            end_states |= SearchSegment(segment, state);
+          }
+        }
+        if (!end_states) {
+          violations.push_back({key_history.first, (states & 1u) != 0, (states & 2u) != 0, segment});
+          break;
+        }
+        states = end_states;
+        begin = end;
+      }
+    }
+    return violations;
+  }
+
+ private:
+  // sequential specification of the set on a single key
+  static bool Step(const HistoryEvent& event, unsigned& state) {
+    bool expected(state != 0);
+    if (Search == event.type_) {
+      return event.result_ == expected;
+    } else if (Insert == event.type_) {
+      state = 1;
+      return event.result_ == !expected;
+    } else {
+      state = 0;
+      return event.result_ == expected;
+    }
+  }
+
+  // return the mask of states reachable at the end of a valid linearization
+  // of segment, segment is ordered by invocation
+  static unsigned SearchSegment(const History& segment, const unsigned& start) {
+    // configuration: every operation before prefix is linearized, plus the
+    // ones listed in extra (sorted), and the current state
+    struct Config {
+      std::size_t prefix_;
+      unsigned state_;
+      std::vector<uint32_t> extra_;
+    };
+
+    unsigned end_states(0);
+    std::set<std::vector<uint32_t>> visited;
+    std::vector<Config> stack;
+    stack.push_back({0, start, std::vector<uint32_t>()});
+
+    while (!stack.empty() && end_states != 3u) {
+      Config config(std::move(stack.back()));
+      stack.pop_back();
+
+      std::vector<uint32_t> memo_key(config.extra_);
+      memo_key.push_back(static_cast<uint32_t>(config.prefix_));
+      memo_key.push_back(config.state_);
+      if (!visited.insert(memo_key).second) {
+        continue;
+      }
+
+      if (config.prefix_ == segment.size()) {
+        end_states |= (1u << config.state_);
+        continue;
+      }
+
+      // an operation may go next unless some pending one responded before
+      // it was invoked
+      std::vector<std::size_t> candidates;
+      int64_t min_response(std::numeric_limits<int64_t>::max());
+      for (std::size_t i(config.prefix_); i < segment.size(); ++i) {
+        if (std::binary_search(config.extra_.begin(), config.extra_.end(), i)) {
+          continue;
+        }
+        if (segment.at(i).invoke_ > min_response) {
+          break;
+        }
+        candidates.push_back(i);
+        min_response = std::min(min_response, segment.at(i).response_);
+      }
+
+      for (auto candidate : candidates) {
+        if (segment.at(candidate).invoke_ > min_response) {
+          continue;
+        }
+        unsigned state(config.state_);
+        if (!Step(segment.at(candidate), state)) {
+          continue;
+        }
+        Config next{config.prefix_, state, config.extra_};
+        next.extra_.insert(std::upper_bound(next.extra_.begin(), next.extra_.end(), candidate),
+                           static_cast<uint32_t>(candidate));
+        // fold linearized operations into the prefix
+        std::size_t folded(0);
+        while (folded < next.extra_.size() && next.extra_.at(folded) == next.prefix_) {
+          ++folded;
+          ++next.prefix_;
+        }
+        next.extra_.erase(next.extra_.begin(), next.extra_.begin() + folded);
+        stack.push_back(std::move(next));
+      }
+    }
+    return end_states;
+  }
+
+  std::set<int> initial_;
+};
+
+} // namespace utils
+
+#endif // CONCURRENT_LINKED_LIST_LINEARIZABILITY_CHECKER_H_
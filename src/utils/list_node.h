@@ -2,6 +2,9 @@
 #define CONCURRENT_LINKED_LIST_LIST_NODE_H_
 
 #include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
 
 namespace utils {
 
@@ -37,7 +40,7 @@ class LockedListNode {
  public:
   LockedListNode(const int& val,
                  LockedListNode* const next,
-                 const bool& marked)
+                 const bool& marked = false)
     : val_(val),
       next_(next),
       marked_(marked) {}
@@ -56,6 +59,33 @@ class LockedListNode {
   std::mutex mutex_;
 };
 
+// LockedListNode which may also be the entry sentinel of a segment
+class SegmentListNode {
+ public:
+  SegmentListNode(const int& val,
+                  SegmentListNode* const next,
+                  const bool& marked = false,
+                  const bool& sentinel = false)
+    : val_(val),
+      next_(next),
+      marked_(marked),
+      sentinel_(sentinel) {}
+
+  ~SegmentListNode(void) {
+    next_ = nullptr;
+  }
+
+  void Lock(void) { mutex_.lock(); }
+
+  void Unlock(void) { mutex_.unlock(); }
+
+  int val_;
+  SegmentListNode* next_;
+  bool marked_;
+  bool sentinel_;
+  std::mutex mutex_;
+};
+
 typedef std::pair<AtomicListNode*, AtomicListNode*> ListWindow;
 typedef std::pair<LockedListNode*, LockedListNode*> LockedListWindow;
 
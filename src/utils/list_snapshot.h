@@ -0,0 +1,183 @@
+#ifndef CONCURRENT_LINKED_LIST_LIST_SNAPSHOT_H_
+#define CONCURRENT_LINKED_LIST_LIST_SNAPSHOT_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+// Snapshot file layout (native byte order):
+//   char[8]  magic "CLLSNAP1"
+//   uint64_t key count
+//   int32_t  keys[count], strictly ascending
+static_assert(sizeof(int) == sizeof(int32_t), "snapshot keys are stored as int32_t");
+
+static constexpr char kSnapshotMagic[8] = {'C', 'L', 'L', 'S', 'N', 'A', 'P', '1'};
+
+struct SnapshotHeader {
+  char magic_[8];
+  uint64_t count_;
+};
+
+// streams keys into a snapshot file, keys are buffered and written in chunks
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(const std::string& path)
+    : path_(path),
+      file_(std::fopen(path.c_str(), "wb")) {
+    if (!file_) {
+      throw std::runtime_error("cannot open snapshot " + path);
+    }
+    std::memcpy(header_.magic_, kSnapshotMagic, sizeof(header_.magic_));
+    header_.count_ = 0;
+    ok_ = std::fwrite(&header_, sizeof(header_), 1, file_) == 1;
+    buffer_.reserve(4096);
+  }
+
+  ~SnapshotWriter(void) {
+    if (file_) {
+      std::fclose(file_);
+    }
+  }
+
+  SnapshotWriter(const SnapshotWriter&) = delete;
+  SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+  void Append(const int& value) {
+    buffer_.push_back(value);
+    if (buffer_.size() == buffer_.capacity()) {
+      Flush();
+    }
+  }
+
+  // patch the key count and close the file, return the key count
+  std::size_t Close(void) {
+    Flush();
+    ok_ = ok_ && std::fseek(file_, 0, SEEK_SET) == 0;
+    ok_ = ok_ && std::fwrite(&header_, sizeof(header_), 1, file_) == 1;
+    ok_ = (std::fclose(file_) == 0) && ok_;
+    file_ = nullptr;
+    if (!ok_) {
+      throw std::runtime_error("cannot write snapshot " + path_);
+    }
+    return header_.count_;
+  }
+
+ private:
+  void Flush(void) {
+    if (!buffer_.empty()) {
+      ok_ = ok_ && std::fwrite(buffer_.data(), sizeof(int32_t), buffer_.size(), file_) == buffer_.size();
+      header_.count_ += buffer_.size();
+      buffer_.clear();
+    }
+  }
+
+  std::string path_;
+  std::FILE* file_;
+  SnapshotHeader header_;
+  bool ok_;
+  std::vector<int32_t> buffer_;
+};
+
+// dump a consistent snapshot of list into path while it is being updated
+// only for lists whose Sync policy provides Snapshot (LockedLinkedList and
+// the lazy lists), updates wait while the dump runs
+template <typename ListType>
+std::size_t DumpSnapshot(ListType& list, const std::string& path) {
+  SnapshotWriter writer(path);
+  list.Snapshot([&writer](const int& value) { writer.Append(value); });
+  return writer.Close();
+}
+
+// dump the keys of list into path without holding updates off
+// the file is only a snapshot if no update runs during the dump
+template <typename ListType>
+std::size_t DumpQuiescentSnapshot(ListType& list, const std::string& path) {
+  SnapshotWriter writer(path);
+  list.ForEach([&writer](const int& value) { writer.Append(value); });
+  return writer.Close();
+}
+
+// read-only mapping of a snapshot file, keys are iterated in place
+class MappedSnapshot {
+ public:
+  explicit MappedSnapshot(const std::string& path)
+    : data_(nullptr),
+      length_(0),
+      count_(0) {
+    int fd(::open(path.c_str(), O_RDONLY));
+    if (fd < 0) {
+      throw std::runtime_error("cannot open snapshot " + path);
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) < 0 ||
+        static_cast<std::size_t>(file_stat.st_size) < sizeof(SnapshotHeader)) {
+      ::close(fd);
+      throw std::runtime_error("invalid snapshot " + path);
+    }
+    length_ = file_stat.st_size;
+    void* data(::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0));
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      throw std::runtime_error("cannot map snapshot " + path);
+    }
+    data_ = static_cast<const char*>(data);
+    ::madvise(data, length_, MADV_SEQUENTIAL);
+
+    const SnapshotHeader* header(reinterpret_cast<const SnapshotHeader*>(data_));
+    count_ = header->count_;
+    if (std::memcmp(header->magic_, kSnapshotMagic, sizeof(header->magic_)) ||
+        count_ > (length_ - sizeof(SnapshotHeader)) / sizeof(int32_t)) {
+      ::munmap(data, length_);
+      throw std::runtime_error("invalid snapshot " + path);
+    }
+    // BuildFromSorted trusts the order, reject a corrupt file here
+    if (std::adjacent_find(begin(), end(), std::greater_equal<int>()) != end()) {
+      ::munmap(data, length_);
+      throw std::runtime_error("unsorted snapshot " + path);
+    }
+  }
+
+  ~MappedSnapshot(void) {
+    ::munmap(const_cast<char*>(data_), length_);
+  }
+
+  MappedSnapshot(const MappedSnapshot&) = delete;
+  MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+  const int* begin(void) const {
+    return reinterpret_cast<const int*>(data_ + sizeof(SnapshotHeader));
+  }
+
+  const int* end(void) const { return begin() + count_; }
+
+  std::size_t size(void) const { return count_; }
+
+ private:
+  const char* data_;
+  std::size_t length_;
+  std::size_t count_;
+};
+
+// bulk-build list from the snapshot in path
+template <typename ListType>
+void LoadSnapshot(ListType& list, const std::string& path,
+                  const std::size_t& thread_num = 1) {
+  MappedSnapshot snapshot(path);
+  list.BuildFromSorted(snapshot.begin(), snapshot.end(), thread_num);
+}
+
+} // namespace utils
+
+#endif // CONCURRENT_LINKED_LIST_LIST_SNAPSHOT_H_
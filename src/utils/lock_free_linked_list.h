@@ -2,82 +2,117 @@
 #define CONCURRENT_LINKED_LIST_LOCK_FREE_LINKED_LIST_H_
 
 #include <atomic>
-#include <limits>
-#include <sstream>
+#include <cstddef>
+#include <utility>
+#include "concurrent_sorted_list.h"
 #include "list_node.h"
-#include "log_util.h"
 
 namespace utils {
 
-class LockFreeLinkedList {
+// Sync policy: lock-free synchronization with marked next pointers
+// CleanupPeriod == 0: Delete marks and unlinks inline
+// CleanupPeriod > 0: Delete only marks, marked runs are unlinked in batch
+//                    by each thread after every CleanupPeriod operations
+// there is no consistent Snapshot, a lock-free list can only be dumped with
+// DumpQuiescentSnapshot
+template <typename Node, std::size_t CleanupPeriod> class BasicLockFreeSync {
  public:
-  LockFreeLinkedList(void)
-    : head_(std::numeric_limits<int>::min(), &tail_),
-      tail_(std::numeric_limits<int>::max(), nullptr) {}
-
-  ~LockFreeLinkedList(void) {
-    AtomicListNode* curr(head_.next_.load());
-    AtomicListNode* tmp(nullptr);
-    while (curr != &tail_) {
-      tmp = curr;
-      curr = ExtractPointer(curr->next_.load());
-      debug_clog << "~LockFreeLinkedList free " << tmp->val_ << std::endl;
-      delete tmp;
-    }
+  typedef std::pair<Node*, Node*> Window;
+
+  // pred of the previous window of a batch, a traversal resumes from it
+  // while its next pointer is unmarked, hence it is still in the list
+  struct Finger {
+    Finger(void)
+      : pred_(nullptr) {}
+
+    Node* pred_;
+  };
+
+  static Node* Next(Node* node) { return ExtractPointer(node->next_.load()); }
+
+  static bool IsDeleted(Node* node) { return IsMarked(node->next_.load()); }
+
+  template <typename ListType> void Rebuild(ListType&) {}
+
+  template <typename ListType> bool Search(ListType& list, const int& value) {
+    Finger finger;
+    return Search(list, value, finger);
+  }
+
+  template <typename ListType> bool Insert(ListType& list, const int& value) {
+    Finger finger;
+    return Insert(list, value, finger);
+  }
+
+  template <typename ListType> bool Delete(ListType& list, const int& value) {
+    Finger finger;
+    return Delete(list, value, finger);
   }
 
-  bool Search(const int& value) {
-    ListWindow window = LocateWindow(value);
-    AtomicListNode* curr(window.second);
+  template <typename ListType> bool Search(ListType& list, const int& value, Finger& finger) {
+    if (CleanupPeriod) {
+      Node* pred_next(nullptr);
+      Window window(LocateDeferredWindow(list, value, pred_next, finger));
+      return (window.second->val_ == value);
+    }
+    Window window = LocateWindow(list, value, finger);
+    Node* curr(window.second);
     return (curr->val_ == value && !IsMarked(curr->next_.load()));
   }
 
-  bool Insert(const int& value) {
+  template <typename ListType> bool Insert(ListType& list, const int& value, Finger& finger) {
+    if (CleanupPeriod) {
+      return DeferredInsert(list, value, finger);
+    }
     while(true) {
       // find a window
-      ListWindow window(LocateWindow(value));
-      AtomicListNode* pred(window.first);
-      AtomicListNode* curr(window.second);
+      Window window(LocateWindow(list, value, finger));
+      Node* pred(window.first);
+      Node* curr(window.second);
 
       // already exists
       if (curr->val_ == value) {
         return false;
       } else {
         // directly set curr means being unmarked
-        AtomicListNode* new_node(new AtomicListNode(value, curr));
+        Node* new_node(list.alloc_.Create(value, curr));
         // if pred->next == curr then pred->next = new_node
         bool res(std::atomic_compare_exchange_strong(&(pred->next_), &curr, new_node));
         if (res) {
           return true;
         } else {
           // failed, just retry
-          delete new_node;
+          list.alloc_.Destroy(new_node);
         }
       }
     }
   }
 
-  bool Delete(const int& value) {
+  template <typename ListType> bool Delete(ListType& list, const int& value, Finger& finger) {
+    if (CleanupPeriod) {
+      return DeferredDelete(list, value, finger);
+    }
     while(true) {
       // find a window
-      ListWindow window = LocateWindow(value);
-      AtomicListNode* pred(window.first);
-      AtomicListNode* curr(window.second);
+      Window window = LocateWindow(list, value, finger);
+      Node* pred(window.first);
+      Node* curr(window.second);
 
       // no such a value
       if (curr->val_ != value) {
         return false;
       } else {
-        AtomicListNode* unmarked_succ(ExtractPointer(curr->next_.load()));
-        AtomicListNode* marked_succ(MarkPointer(unmarked_succ));
+        Node* unmarked_succ(ExtractPointer(curr->next_.load()));
+        Node* marked_succ(MarkPointer(unmarked_succ));
         // validate and mark: res := CAS(curr->next, <0, succ>, <1, succ>)
         bool res(std::atomic_compare_exchange_strong(&(curr->next_), &unmarked_succ, marked_succ));
         if (res) {
-          AtomicListNode* unmarked_curr(ExtractPointer(curr));
+          Node* unmarked_curr(ExtractPointer(curr));
           // change pointer: CAS(pred->next, <0, curr>, <0, succ>)
-          std::atomic_compare_exchange_strong(&(pred->next_), &unmarked_curr, unmarked_succ);
-          // TODO: find a way to delete it
-          // delete unmarked_curr;
+          // otherwise a later traversal will unlink and retire it
+          if (std::atomic_compare_exchange_strong(&(pred->next_), &unmarked_curr, unmarked_succ)) {
+            list.reclaim_.Retire(curr, list.alloc_);
+          }
           return true;
         }
         // if validation failed, just retry
@@ -85,31 +120,16 @@ class LockFreeLinkedList {
     }
   }
 
-  std::string ToString(void) {
-    std::stringstream ss;
-    AtomicListNode* curr(head_.next_);
-    while (curr != &tail_) {
-      ss << curr->val_;
-      if (curr->next_ != &tail_) {
-        ss << " ";
-      }
-      curr = curr->next_;
-    }
-    return ss.str();
-  }
-
  private:
-  AtomicListNode head_;
-  AtomicListNode tail_;
-
-  ListWindow LocateWindow(const int& key) {
+  template <typename ListType> Window LocateWindow(ListType& list, const int& key, Finger& finger) {
   retry:
     while (true) {
-      AtomicListNode* unmarked_pred(&head_);
-      AtomicListNode* unmarked_curr(ExtractPointer(head_.next_.load()));
+      Node* unmarked_pred(&list.head_);
+      Node* unmarked_curr(ExtractPointer(list.head_.next_.load()));
+      Resume(finger, key, unmarked_pred, unmarked_curr);
 
       while (true) {
-        AtomicListNode* unmarked_succ(ExtractPointer(unmarked_curr->next_.load()));
+        Node* unmarked_succ(ExtractPointer(unmarked_curr->next_.load()));
         bool marked_flag(IsMarked(unmarked_curr->next_.load()));
         // clear all marked node while moving forward
         while (marked_flag) {
@@ -117,8 +137,7 @@ class LockFreeLinkedList {
           if (!res) {
             goto retry;
           } else {
-            // TODO: find a way to delete it
-            // delete unmarked_curr;
+            list.reclaim_.Retire(unmarked_curr, list.alloc_);
             // move forward
             unmarked_curr = unmarked_succ;
             unmarked_succ = ExtractPointer(unmarked_curr->next_.load());
@@ -128,6 +147,7 @@ class LockFreeLinkedList {
 
         // find a window
         if (unmarked_curr->val_ >= key) {
+          finger.pred_ = unmarked_pred;
           return std::make_pair(unmarked_pred, unmarked_curr);
         }
 
@@ -138,10 +158,170 @@ class LockFreeLinkedList {
     }
   }
 
+  template <typename ListType> bool DeferredInsert(ListType& list, const int& value, Finger& finger) {
+    Node* new_node(nullptr);
+    while (true) {
+      // find a window, pred_next is the (possibly marked) node following pred
+      Node* pred_next(nullptr);
+      Window window(LocateDeferredWindow(list, value, pred_next, finger));
+      Node* pred(window.first);
+      Node* curr(window.second);
+
+      // already exists
+      if (curr->val_ == value) {
+        if (new_node) {
+          list.alloc_.Destroy(new_node);
+        }
+        Maintain(list);
+        return false;
+      }
+
+      if (!new_node) {
+        new_node = list.alloc_.Create(value, curr);
+      } else {
+        new_node->next_.store(curr);
+      }
+      // if pred->next == pred_next then pred->next = new_node
+      // nodes between pred_next and curr are marked and frozen, so this also
+      // unlinks them with the same CAS
+      Node* run(pred_next);
+      if (std::atomic_compare_exchange_strong(&(pred->next_), &pred_next, new_node)) {
+        RetireRun(list, run, curr);
+        Maintain(list);
+        return true;
+      }
+      // failed, just retry
+    }
+  }
+
+  template <typename ListType> bool DeferredDelete(ListType& list, const int& value, Finger& finger) {
+    while (true) {
+      // find a window
+      Node* pred_next(nullptr);
+      Window window(LocateDeferredWindow(list, value, pred_next, finger));
+      Node* curr(window.second);
+
+      // no such a value
+      if (curr->val_ != value) {
+        Maintain(list);
+        return false;
+      }
+
+      // only mark: CAS(curr->next, <0, succ>, <1, succ>), unlink is deferred
+      Node* unmarked_succ(ExtractPointer(curr->next_.load()));
+      Node* marked_succ(MarkPointer(unmarked_succ));
+      if (std::atomic_compare_exchange_strong(&(curr->next_), &unmarked_succ, marked_succ)) {
+        Maintain(list);
+        return true;
+      }
+      // if validation failed, just retry
+    }
+  }
+
+  // return <pred, curr> where pred is the last unmarked node whose value is
+  // less than key and curr is the first unmarked node whose value is not less
+  // than key, marked nodes in between are skipped without any CAS
+  template <typename ListType>
+  Window LocateDeferredWindow(ListType& list, const int& key, Node*& pred_next, Finger& finger) {
+    Node* pred(&list.head_);
+    pred_next = ExtractPointer(list.head_.next_.load());
+    Resume(finger, key, pred, pred_next);
+    Node* curr(pred_next);
+
+    while (true) {
+      Node* succ(curr->next_.load());
+      if (IsMarked(succ)) {
+        // logically deleted, skip it
+        curr = ExtractPointer(succ);
+        continue;
+      }
+
+      // find a window
+      if (curr->val_ >= key) {
+        finger.pred_ = pred;
+        return std::make_pair(pred, curr);
+      }
+
+      // move forward
+      pred = curr;
+      pred_next = succ;
+      curr = succ;
+    }
+  }
+
+  // start from the finger instead of head_ if it is still in the list and
+  // before key, pred_next is its successor read in the same load
+  static void Resume(const Finger& finger, const int& key, Node*& pred, Node*& pred_next) {
+    Node* hint(finger.pred_);
+    if (hint && hint->val_ < key) {
+      Node* hint_next(hint->next_.load());
+      if (!IsMarked(hint_next)) {
+        pred = hint;
+        pred_next = hint_next;
+      }
+    }
+  }
+
+  // amortized helping: every CleanupPeriod operations of a thread
+  template <typename ListType> void Maintain(ListType& list) {
+    static thread_local std::size_t op_count(0);
+    if (++op_count % CleanupPeriod == 0) {
+      UnlinkMarkedRuns(list);
+    }
+  }
+
+  // unlink every run of consecutive marked nodes with a single CAS per run
+  template <typename ListType> void UnlinkMarkedRuns(ListType& list) {
+    Node* pred(&list.head_);
+    while (pred != &list.tail_) {
+      Node* pred_next(pred->next_.load());
+      if (IsMarked(pred_next)) {
+        // pred itself has been deleted meanwhile, skip it
+        pred = ExtractPointer(pred_next);
+        continue;
+      }
+
+      // find the end of the marked run
+      Node* curr(pred_next);
+      while (IsMarked(curr->next_.load())) {
+        curr = ExtractPointer(curr->next_.load());
+      }
+
+      if (curr != pred_next) {
+        // change pointer: CAS(pred->next, <0, first marked>, <0, curr>)
+        // on failure the run is left for the next pass
+        Node* run(pred_next);
+        if (std::atomic_compare_exchange_strong(&(pred->next_), &pred_next, curr)) {
+          RetireRun(list, run, curr);
+        }
+      }
+
+      pred = curr;
+    }
+  }
+
+  // retire the unlinked nodes in [first, last), marked links never change
+  template <typename ListType> void RetireRun(ListType& list, Node* first, Node* last) {
+    list.reclaim_.RetireRun(first, last, list.alloc_);
+  }
+
  public:
-  static constexpr auto name_ = "LockFreeLinkedList";
+  static constexpr auto name_ = CleanupPeriod ? "DeferredLockFreeLinkedList" : "LockFreeLinkedList";
 };
 
+template <typename Node> using LockFreeSync = BasicLockFreeSync<Node, 0>;
+
+// unlink marked runs every 64 operations per thread
+template <typename Node> using DeferredLockFreeSync = BasicLockFreeSync<Node, 64>;
+
+typedef ConcurrentSortedList<AtomicListNode, LockFreeSync, RetireReclaim, NewAlloc> LockFreeLinkedList;
+
+// LockFreeLinkedList with deferred batch unlinking of deleted nodes
+typedef ConcurrentSortedList<AtomicListNode, DeferredLockFreeSync, RetireReclaim, NewAlloc> DeferredLockFreeLinkedList;
+
+// LockFreeLinkedList whose nodes come from a PoolAlloc
+typedef ConcurrentSortedList<AtomicListNode, LockFreeSync, RetireReclaim, PoolAlloc> PooledLockFreeLinkedList;
+
 } // namespace utils
 
 #endif // CONCURRENT_LINKED_LIST_LOCK_FREE_LINKED_LIST_H_
@@ -0,0 +1,76 @@
+#ifndef CONCURRENT_LINKED_LIST_OPERATION_H_
+#define CONCURRENT_LINKED_LIST_OPERATION_H_
+
+namespace utils {
+
+enum OperationType {
+  Search = 0,
+  Insert = 1,
+  Delete = 2
+};
+
+template <OperationType Type> struct Operation;
+
+template <> struct Operation<Search> {
+  template <typename ListType> static bool Apply(ListType& list, const int& key) {
+    return list.Search(key);
+  }
+  template <typename ListType, typename Finger>
+  static bool Apply(ListType& list, const int& key, Finger& finger) {
+    return list.Search(key, finger);
+  }
+  static constexpr auto name_ = "Search";
+};
+
+template <> struct Operation<Insert> {
+  template <typename ListType> static bool Apply(ListType& list, const int& key) {
+    return list.Insert(key);
+  }
+  template <typename ListType, typename Finger>
+  static bool Apply(ListType& list, const int& key, Finger& finger) {
+    return list.Insert(key, finger);
+  }
+  static constexpr auto name_ = "Insert";
+};
+
+template <> struct Operation<Delete> {
+  template <typename ListType> static bool Apply(ListType& list, const int& key) {
+    return list.Delete(key);
+  }
+  template <typename ListType, typename Finger>
+  static bool Apply(ListType& list, const int& key, Finger& finger) {
+    return list.Delete(key, finger);
+  }
+  static constexpr auto name_ = "Delete";
+};
+
+// run the operation selected at runtime
+template <typename ListType>
+inline bool Apply(ListType& list, const OperationType& type, const int& key) {
+  switch (type) {
+    case Search:
+      return Operation<Search>::Apply(list, key);
+    case Insert:
+      return Operation<Insert>::Apply(list, key);
+    default:
+      return Operation<Delete>::Apply(list, key);
+  }
+}
+
+// run the operation selected at runtime as part of a batch sorted by key
+template <typename ListType>
+inline bool Apply(ListType& list, const OperationType& type, const int& key,
+                  typename ListType::Finger& finger) {
+  switch (type) {
+    case Search:
+      return Operation<Search>::Apply(list, key, finger);
+    case Insert:
+      return Operation<Insert>::Apply(list, key, finger);
+    default:
+      return Operation<Delete>::Apply(list, key, finger);
+  }
+}
+
+} // namespace utils
+
+#endif // CONCURRENT_LINKED_LIST_OPERATION_H_
@@ -0,0 +1,317 @@
+#ifndef CONCURRENT_LINKED_LIST_SEGMENTED_LINKED_LIST_H_
+#define CONCURRENT_LINKED_LIST_SEGMENTED_LINKED_LIST_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "concurrent_sorted_list.h"
+#include "fine_grained_linked_list.h"
+#include "list_node.h"
+
+namespace utils {
+
+// default thresholds of SegmentDirectory
+struct SegmentTuning {
+  // sample one operation in kSamplePeriod of each thread
+  static constexpr std::size_t kSamplePeriod = 8;
+  // try to rebalance every kRebalancePeriod samples of each thread
+  static constexpr std::size_t kRebalancePeriod = 128;
+  // samples needed before the statistics are trusted
+  static constexpr std::size_t kMinSamples = 64;
+  // bound on the segments and on the sentinels linked into the list
+  static constexpr std::size_t kMaxSegments = 1024;
+  // average traversal length above which a hot segment is split
+  static constexpr std::size_t kSplitHops = 32;
+  // combined average traversal length below which cold neighbours are merged
+  static constexpr std::size_t kMergeHops = 8;
+  static constexpr auto name_ = "SegmentedLazyLinkedList";
+};
+
+// Entry policy of BasicLazySync: the list is partitioned by splitter keys,
+// each segment starts at its own entry sentinel linked into the list.
+// A read-mostly directory maps a key to the sentinel of its segment, so a
+// traversal only walks its segment. Sentinels sort before a real node with
+// the same value and are never marked or unlinked while the list is in use,
+// so a traversal may start from any sentinel, even one from an old directory.
+// Traversal lengths are sampled per segment; hot and long segments are split
+// at their median key, cold and short neighbours are merged.
+// A merge leaves the sentinel of the second segment linked as an orphan, a
+// later split reuses an orphan close to its median instead of linking a new
+// sentinel, and at most Tuning::kMaxSegments sentinels are ever linked.
+template <typename Node, typename Tuning> class BasicSegmentDirectory {
+ private:
+  struct Directory;
+
+ public:
+  struct Ticket {
+    Directory* directory_;
+    std::size_t segment_;
+  };
+
+  BasicSegmentDirectory(void)
+    : current_(nullptr),
+      sentinel_num_(0) {}
+
+  ~BasicSegmentDirectory(void) {
+    delete current_.load();
+    for (auto directory : retired_) {
+      delete directory;
+    }
+  }
+
+  static bool IsSentinel(Node* node) { return node->sentinel_; }
+
+  // whether a traversal for key must move past node
+  static bool Before(Node* node, const int& key) {
+    return (node->val_ < key || (node->sentinel_ && node->val_ == key));
+  }
+
+  Node* Enter(Node* head, const int& key, Ticket& ticket) {
+    Directory* directory(current_.load(std::memory_order_acquire));
+    if (!directory) {
+      directory = Init(head);
+    }
+    auto splitter(std::upper_bound(directory->splitters_.begin(), directory->splitters_.end(), key));
+    ticket.directory_ = directory;
+    ticket.segment_ = splitter - directory->splitters_.begin() - 1;
+    return directory->entries_.at(ticket.segment_);
+  }
+
+  // sample every kSamplePeriod operations of a thread, a rebalance is due
+  // every kRebalancePeriod samples; runs on the search path, so it only
+  // touches the relaxed counters
+  void Leave(const Ticket& ticket, const std::size_t& hops) {
+    LocalState& local(Local());
+    if (++local.op_count_ % Tuning::kSamplePeriod) {
+      return;
+    }
+    ticket.directory_->ops_[ticket.segment_].fetch_add(1, std::memory_order_relaxed);
+    ticket.directory_->hops_[ticket.segment_].fetch_add(hops, std::memory_order_relaxed);
+    if (local.op_count_ % (Tuning::kSamplePeriod * Tuning::kRebalancePeriod) == 0) {
+      local.rebalance_due_ = true;
+    }
+  }
+
+  // called by updates once their node locks are released, run the
+  // rebalance the thread's samples made due
+  template <typename Alloc> void Maintain(Node* tail, Alloc& alloc) {
+    LocalState& local(Local());
+    if (local.rebalance_due_) {
+      local.rebalance_due_ = false;
+      Rebalance(tail, alloc);
+    }
+  }
+
+  // the sentinels are gone after a bulk operation, start over with one segment
+  void Rebuild(Node*) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    Directory* directory(current_.exchange(nullptr));
+    if (directory) {
+      retired_.push_back(directory);
+    }
+    sentinel_num_ = 0;
+  }
+
+  static constexpr auto name_ = Tuning::name_;
+
+ private:
+  // immutable once published, except for the statistics
+  struct Directory {
+    explicit Directory(const std::size_t& size)
+      : splitters_(size),
+        entries_(size),
+        ops_(new std::atomic<std::size_t>[size]),
+        hops_(new std::atomic<std::size_t>[size]) {
+      for (std::size_t i(0); i < size; ++i) {
+        ops_[i].store(0);
+        hops_[i].store(0);
+      }
+    }
+
+    // splitters_[0] is the minimum int and entries_[0] is head_
+    std::vector<int> splitters_;
+    std::vector<Node*> entries_;
+    std::unique_ptr<std::atomic<std::size_t>[]> ops_;
+    std::unique_ptr<std::atomic<std::size_t>[]> hops_;
+  };
+
+  typedef std::pair<Node*, Node*> Window;
+
+  struct LocalState {
+    std::size_t op_count_;
+    bool rebalance_due_;
+  };
+
+  static LocalState& Local(void) {
+    static thread_local LocalState local{0, false};
+    return local;
+  }
+
+  Directory* Init(Node* head) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!current_.load()) {
+      Directory* directory(new Directory(1));
+      directory->splitters_.at(0) = std::numeric_limits<int>::min();
+      directory->entries_.at(0) = head;
+      current_.store(directory, std::memory_order_release);
+    }
+    return current_.load();
+  }
+
+  template <typename Alloc> void Rebalance(Node* tail, Alloc& alloc) {
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return;
+    }
+    Directory* directory(current_.load());
+    if (!directory) {
+      return;
+    }
+
+    std::size_t size(directory->splitters_.size());
+    std::vector<std::size_t> ops(size);
+    std::vector<std::size_t> avg_hops(size);
+    std::size_t total_ops(0);
+    for (std::size_t i(0); i < size; ++i) {
+      ops.at(i) = directory->ops_[i].load(std::memory_order_relaxed);
+      avg_hops.at(i) = ops.at(i) ? directory->hops_[i].load(std::memory_order_relaxed) / ops.at(i) : 0;
+      total_ops += ops.at(i);
+    }
+    if (total_ops < Tuning::kMinSamples) {
+      return;
+    }
+    std::size_t mean_ops(total_ops / size);
+
+    std::vector<std::pair<int, Node*>> segments;
+    bool changed(false);
+    for (std::size_t i(0); i < size; ++i) {
+      segments.push_back(std::make_pair(directory->splitters_.at(i), directory->entries_.at(i)));
+      // the entries after i are still to be copied
+      if (avg_hops.at(i) > Tuning::kSplitHops && ops.at(i) >= mean_ops &&
+          segments.size() + size - i <= Tuning::kMaxSegments) {
+        // hot and long: split
+        Node* end(i + 1 < size ? directory->entries_.at(i + 1) : tail);
+        Node* sentinel(Split(directory->entries_.at(i), end, alloc));
+        if (sentinel) {
+          segments.push_back(std::make_pair(sentinel->val_, sentinel));
+          changed = true;
+        }
+      } else if (i + 1 < size && avg_hops.at(i) + avg_hops.at(i + 1) < Tuning::kMergeHops &&
+                 ops.at(i) + ops.at(i + 1) < mean_ops) {
+        // cold and short neighbours: merge, the sentinel of the second one
+        // stays in the list but is no longer an entry
+        ++i;
+        changed = true;
+      }
+    }
+
+    if (!changed) {
+      for (std::size_t i(0); i < size; ++i) {
+        directory->ops_[i].store(0, std::memory_order_relaxed);
+        directory->hops_[i].store(0, std::memory_order_relaxed);
+      }
+      return;
+    }
+
+    Directory* fresh(new Directory(segments.size()));
+    for (std::size_t i(0); i < segments.size(); ++i) {
+      fresh->splitters_.at(i) = segments.at(i).first;
+      fresh->entries_.at(i) = segments.at(i).second;
+    }
+    // readers may still hold the old directory
+    retired_.push_back(directory);
+    current_.store(fresh, std::memory_order_release);
+  }
+
+  // return a sentinel cutting the segment [entry, end) near its median,
+  // nullptr if the segment is too short or no sentinel may be linked
+  template <typename Alloc> Node* Split(Node* entry, Node* end, Alloc& alloc) {
+    // every sentinel inside a segment is an orphan, remember how many live
+    // nodes precede it
+    std::size_t count(0);
+    std::vector<std::pair<std::size_t, Node*>> orphans;
+    for (Node* curr(entry->next_); curr != end; curr = curr->next_) {
+      if (curr->sentinel_) {
+        orphans.push_back(std::make_pair(count, curr));
+      } else if (!curr->marked_) {
+        ++count;
+      }
+    }
+    if (count < 2) {
+      return nullptr;
+    }
+
+    // reuse the orphan closest to the median if it lies in the middle half
+    Node* reused(nullptr);
+    std::size_t best_distance(count / 4 + 1);
+    for (auto& orphan : orphans) {
+      std::size_t distance(orphan.first > count / 2 ? orphan.first - count / 2 : count / 2 - orphan.first);
+      if (orphan.first && orphan.first < count && distance < best_distance) {
+        reused = orphan.second;
+        best_distance = distance;
+      }
+    }
+    if (reused) {
+      return reused;
+    }
+    if (sentinel_num_ >= Tuning::kMaxSegments) {
+      return nullptr;
+    }
+
+    Node* median(entry->next_);
+    for (std::size_t seen(0); median != end; median = median->next_) {
+      if (!median->marked_ && !median->sentinel_ && seen++ == count / 2) {
+        break;
+      }
+    }
+    if (median == end || median->val_ <= entry->val_) {
+      return nullptr;
+    }
+    int key(median->val_);
+
+    // same locking protocol as BasicLazySync::Insert
+    while (true) {
+      Node* pred(entry);
+      Node* curr(entry->next_);
+      while (curr->val_ < key) {
+        pred = curr;
+        curr = curr->next_;
+      }
+      if (curr->sentinel_ && curr->val_ == key) {
+        // reuse a sentinel left by an earlier merge
+        return curr;
+      }
+
+      Window window(std::make_pair(pred, curr));
+      WindowGuard<Window> guard(window);
+      if (!pred->marked_ && !curr->marked_ && pred->next_ == curr) {
+        Node* sentinel(alloc.Create(key, curr, false, true));
+        pred->next_ = sentinel;
+        ++sentinel_num_;
+        return sentinel;
+      }
+    }
+  }
+
+  std::atomic<Directory*> current_;
+  // guards the fields below and every directory update
+  std::mutex mutex_;
+  std::vector<Directory*> retired_;
+  // sentinels linked into the list, head_ excluded
+  std::size_t sentinel_num_;
+};
+
+template <typename Node> using SegmentDirectory = BasicSegmentDirectory<Node, SegmentTuning>;
+
+template <typename Node> using SegmentedLazySync = BasicLazySync<Node, SegmentDirectory>;
+
+typedef ConcurrentSortedList<SegmentListNode, SegmentedLazySync, RetireReclaim, NewAlloc> SegmentedLazyLinkedList;
+
+} // namespace utils
+
+#endif // CONCURRENT_LINKED_LIST_SEGMENTED_LINKED_LIST_H_
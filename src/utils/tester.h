@@ -2,27 +2,33 @@
 #define CONCURRENT_LINKED_LIST_TESTER_H_
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 #include "coarse_grained_linked_list.h"
+#include "async_list.h"
 #include "fine_grained_linked_list.h"
+#include "history.h"
+#include "linearizability_checker.h"
+#include "list_snapshot.h"
 #include "lock_free_linked_list.h"
 #include "log_util.h"
+#include "operation.h"
+#include "segmented_linked_list.h"
 
 namespace utils {
 
-enum OperationType {
-  Search = 0,
-  Insert = 1,
-  Delete = 2
-};
-
 struct TestOperation {
   OperationType type_;
   int parameter_;
@@ -62,27 +68,6 @@ class TestThroughput {
   std::array<OpThroughput, 3> profile_;
 };
 
-#ifndef NDEBUG
-#define CALL_FUNC_IF_MATCH(FUNC_NAME)                               \
-if (operation.type_ == FUNC_NAME) {                                 \
-  sstr.str("");                                                     \
-  sstr << "[thread " << id << "] " << linked_list_.name_            \
-             << "::"#FUNC_NAME"(" << operation.parameter_ << ")\n"; \
-  std::clog << sstr.str();                                          \
-  ret = linked_list_.FUNC_NAME(operation.parameter_);               \
-  sstr.str("");                                                     \
-  sstr << "[thread " << id << "] " << linked_list_.name_            \
-             << "::"#FUNC_NAME"(" << operation.parameter_ << ") = " \
-             << std::boolalpha << ret << "\n";                      \
-  std::clog << sstr.str();                                          \
-}
-#else
-#define CALL_FUNC_IF_MATCH(FUNC_NAME)           \
-if (operation.type_ == FUNC_NAME) {             \
-  linked_list_.FUNC_NAME(operation.parameter_); \
-}
-#endif
-
 template <typename ListType> class UnitTester {
  public:
   UnitTester(void) {}
@@ -91,20 +76,24 @@ template <typename ListType> class UnitTester {
   static std::string GetName(void) { return ListType::name_; }
 
   void ThreadFunc(const std::size_t& id, const std::vector<TestOperation>& operation_list) {
+    for (auto operation : operation_list) {
 #ifndef NDEBUG
-    bool ret;
-    std::stringstream sstr;
+      recorder_->Invoke(linked_list_, id, operation.type_, operation.parameter_);
+#else
+      Apply(linked_list_, operation.type_, operation.parameter_);
 #endif
-    for (auto operation : operation_list) {
-      CALL_FUNC_IF_MATCH(Search)
-      CALL_FUNC_IF_MATCH(Insert)
-      CALL_FUNC_IF_MATCH(Delete)
     }
   }
 
   TestResult UnitTest(const std::vector<std::vector<TestOperation>>& operation_list_group) {
-    debug_clog << "--- [" << linked_list_.name_ << "] Thread = "
-               << operation_list_group.size() << " Concurrent History ---\n";
+#ifndef NDEBUG
+    // record instead of logging every operation, which would serialize threads
+    std::size_t max_operation_num(0);
+    for (auto& operation_list : operation_list_group) {
+      max_operation_num = std::max(max_operation_num, operation_list.size());
+    }
+    recorder_.reset(new HistoryRecorder(operation_list_group.size(), max_operation_num));
+#endif
 
     auto begin = std::chrono::steady_clock::now();
 
@@ -118,6 +107,18 @@ template <typename ListType> class UnitTester {
 
     auto end = std::chrono::steady_clock::now();
 
+#ifndef NDEBUG
+    History history(recorder_->Collect());
+    debug_clog << "--- [" << linked_list_.name_ << "] Thread = "
+               << operation_list_group.size() << " Concurrent History ---\n";
+    for (auto& event : history) {
+      debug_clog << EventToString(event, history.front().invoke_) << "\n";
+    }
+    for (auto& violation : LinearizabilityChecker().Check(history)) {
+      debug_clog << "--- [" << linked_list_.name_ << "] " << violation.ToString();
+    }
+#endif
+
     debug_clog << "--- [" << linked_list_.name_ << "] Thread = " << operation_list_group.size() << ", Total Time = "
               << std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()
               << " (ns) ---" << std::endl;
@@ -129,28 +130,106 @@ template <typename ListType> class UnitTester {
  private:
   ListType linked_list_;
   std::vector<std::thread> thread_pool;
+#ifndef NDEBUG
+  std::unique_ptr<HistoryRecorder> recorder_;
+#endif
 };
 
-class Tester {
+// each producer thread submits its operations through an AsyncList and
+// records the latency from submission to completion of every operation
+template <typename ListType> class AsyncUnitTester {
+ public:
+  AsyncUnitTester(const std::size_t& worker_num)
+    : async_list_(linked_list_, worker_num) {}
+  ~AsyncUnitTester(void) {}
+
+  // return <total time, mean latency>
+  std::pair<TestResult, TestResult> UnitTest(const std::vector<std::vector<TestOperation>>& operation_list_group) {
+    std::size_t total(0);
+    std::vector<std::vector<TestResult>> latency_group(operation_list_group.size());
+    for (std::size_t i(0); i < operation_list_group.size(); i++) {
+      latency_group.at(i).resize(operation_list_group.at(i).size());
+      total += operation_list_group.at(i).size();
+    }
+    std::atomic<std::size_t> done(0);
+
+    auto begin = std::chrono::steady_clock::now();
+
+    for (std::size_t i(0); i < operation_list_group.size(); i++) {
+      this->thread_pool.emplace_back([this, &operation_list_group, &latency_group, &done, i] {
+        auto& operation_list(operation_list_group.at(i));
+        auto& latency_list(latency_group.at(i));
+        for (std::size_t j(0); j < operation_list.size(); j++) {
+          TestResult& latency(latency_list.at(j));
+          auto submit = std::chrono::steady_clock::now();
+          this->async_list_.Submit(operation_list.at(j).type_, operation_list.at(j).parameter_,
+                                   [&latency, &done, submit](const bool&) {
+                                     latency = std::chrono::steady_clock::now() - submit;
+                                     done.fetch_add(1);
+                                   });
+        }
+      });
+    }
+
+    for (auto& thread : thread_pool) {
+      thread.join();
+    }
+
+    while (done.load() != total) {
+      std::this_thread::yield();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    TestResult latency_sum(0);
+    for (auto& latency_list : latency_group) {
+      for (auto& latency : latency_list) {
+        latency_sum += latency;
+      }
+    }
+
+    debug_clog << "--- [" << linked_list_.name_ << "] Async Thread = " << operation_list_group.size() << ", Total Time = "
+               << std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()
+               << " (ns) ---" << std::endl;
+
+    thread_pool.clear();
+    return std::make_pair(end - begin, total ? latency_sum / total : latency_sum);
+  }
+
+ private:
+  ListType linked_list_;
+  AsyncList<ListType> async_list_;
+  std::vector<std::thread> thread_pool;
+};
+
+// benchmark every list in ListTypes against the same operations
+// with async_worker_num > 0 the operations are also run through an AsyncList
+template <typename... ListTypes> class Tester {
  public:
   Tester(const std::size_t& max_thread_num,
          const std::size_t& operation_num,
          const std::size_t& repeat_times,
          const std::vector<TestThroughput>& throughput_list,
-         const KeySpace& key_space)
+         const KeySpace& key_space,
+         const std::size_t& async_worker_num = 0)
     : max_thread_num_(max_thread_num),
       operation_num_(operation_num),
       repeat_times_(repeat_times),
+      async_worker_num_(async_worker_num),
       throughput_list_(throughput_list),
       profile_dist_(0, throughput_list.front().profile_.size() - 1),
       key_dist_(key_space.first, key_space.second),
       dist_(0, std::numeric_limits<std::size_t>::max()) {
     random_engine_.seed(std::random_device()());
-    test_results_.resize(throughput_list.size());
-    for (auto& test_result : test_results_) {
-      std::get<0>(test_result).resize(max_thread_num_);
-      std::get<1>(test_result).resize(max_thread_num_);
-      std::get<2>(test_result).resize(max_thread_num_);
+    // test_results_[profile][list][thread number - 1]
+    for (auto results : {&test_results_, &async_time_results_, &async_latency_results_}) {
+      results->resize(throughput_list.size());
+      for (auto& test_result : *results) {
+        test_result.resize(sizeof...(ListTypes));
+        for (auto& list_result : test_result) {
+          list_result.resize(max_thread_num_);
+        }
+      }
     }
   }
 
@@ -204,18 +283,26 @@ class Tester {
           std::vector<std::vector<TestOperation>> operation_list_group;
           GenerateOperations(throughput_list_.at(i), t_num, operation_num_, operation_list_group);
 
-          utils::UnitTester<utils::LockedLinkedList> coarse_grained_tester;
-          utils::UnitTester<utils::LazyLinkedList> fine_grained_tester;
-          utils::UnitTester<utils::LockFreeLinkedList> lock_free_tester;
-          std::get<0>(test_results_.at(i)).at(t_num - 1) += coarse_grained_tester.UnitTest(operation_list_group);
-          std::get<1>(test_results_.at(i)).at(t_num - 1) += fine_grained_tester.UnitTest(operation_list_group);
-          std::get<2>(test_results_.at(i)).at(t_num - 1) += lock_free_tester.UnitTest(operation_list_group);
+          std::size_t list_index(0);
+          int expand[] = {0, (RunUnitTest<ListTypes>(test_results_.at(i).at(list_index++).at(t_num - 1),
+                                                     operation_list_group), 0)...};
+          static_cast<void>(expand);
+
+          if (async_worker_num_) {
+            std::size_t async_index(0);
+            int async_expand[] = {0, (RunAsyncUnitTest<ListTypes>(async_time_results_.at(i).at(async_index).at(t_num - 1),
+                                                                  async_latency_results_.at(i).at(async_index).at(t_num - 1),
+                                                                  operation_list_group), ++async_index, 0)...};
+            static_cast<void>(async_expand);
+          }
         }
 
         // average
-        std::get<0>(test_results_.at(i)).at(t_num - 1) /= repeat_times_;
-        std::get<1>(test_results_.at(i)).at(t_num - 1) /= repeat_times_;
-        std::get<2>(test_results_.at(i)).at(t_num - 1) /= repeat_times_;
+        for (auto results : {&test_results_, &async_time_results_, &async_latency_results_}) {
+          for (auto& list_result : results->at(i)) {
+            list_result.at(t_num - 1) /= repeat_times_;
+          }
+        }
       }
     }
   }
@@ -231,31 +318,77 @@ class Tester {
                  << ", test times: " << repeat_times_
                  << ", Time Unit: Nanosecond"
                  << std::endl;
-
-      // header
-      out_stream << "ThreadNumber, "
-                 << utils::UnitTester<utils::LockedLinkedList>::GetName() << ", "
-                 << utils::UnitTester<utils::LazyLinkedList>::GetName() << ", "
-                 << utils::UnitTester<utils::LockFreeLinkedList>::GetName() << std::endl;
-
-      // line
-      for (std::size_t j = 0; j < max_thread_num_; j++) {
-        out_stream << j + 1 << ", "
-                   << std::get<0>(test_results_.at(i)).at(j).count() << ", "
-                   << std::get<1>(test_results_.at(i)).at(j).count() << ", "
-                   << std::get<2>(test_results_.at(i)).at(j).count() << std::endl;
+      out_stream << TableToString(test_results_.at(i)) << std::endl;
+
+      if (async_worker_num_) {
+        out_stream << throughput_list_.at(i).ToString()
+                   << "Async Total Time, Worker Number: " << async_worker_num_
+                   << ", Thread Number: 1 ~ " << max_thread_num_
+                   << ", Operation Number: " << operation_num_
+                   << ", test times: " << repeat_times_
+                   << ", Time Unit: Nanosecond"
+                   << std::endl;
+        out_stream << TableToString(async_time_results_.at(i)) << std::endl;
+
+        out_stream << throughput_list_.at(i).ToString()
+                   << "Async Mean Latency, Worker Number: " << async_worker_num_
+                   << ", Thread Number: 1 ~ " << max_thread_num_
+                   << ", Operation Number: " << operation_num_
+                   << ", test times: " << repeat_times_
+                   << ", Time Unit: Nanosecond"
+                   << std::endl;
+        out_stream << TableToString(async_latency_results_.at(i)) << std::endl;
       }
+    }
 
+    return out_stream.str();
+  }
+
+ private:
+  template <typename ListType>
+  void RunUnitTest(TestResult& result,
+                   const std::vector<std::vector<TestOperation>>& operation_list_group) {
+    UnitTester<ListType> tester;
+    result += tester.UnitTest(operation_list_group);
+  }
+
+  template <typename ListType>
+  void RunAsyncUnitTest(TestResult& time_result, TestResult& latency_result,
+                        const std::vector<std::vector<TestOperation>>& operation_list_group) {
+    AsyncUnitTester<ListType> tester(async_worker_num_);
+    auto result(tester.UnitTest(operation_list_group));
+    time_result += result.first;
+    latency_result += result.second;
+  }
+
+  // results of one profile, a row per thread number and a column per list
+  std::string TableToString(const std::vector<std::vector<TestResult>>& results) {
+    std::stringstream out_stream;
+    std::vector<std::string> names = {UnitTester<ListTypes>::GetName()...};
+
+    // header
+    out_stream << "ThreadNumber";
+    for (auto& name : names) {
+      out_stream << ", " << name;
+    }
+    out_stream << std::endl;
+
+    // line
+    for (std::size_t j = 0; j < max_thread_num_; j++) {
+      out_stream << j + 1;
+      for (auto& list_result : results) {
+        out_stream << ", " << list_result.at(j).count();
+      }
       out_stream << std::endl;
     }
 
     return out_stream.str();
   }
 
- private:
   std::size_t max_thread_num_;
   std::size_t operation_num_;
   std::size_t repeat_times_;
+  std::size_t async_worker_num_;
   std::vector<TestThroughput> throughput_list_;
 
   std::mt19937 random_engine_;
@@ -263,7 +396,232 @@ class Tester {
   std::uniform_int_distribution<int> key_dist_;
   std::uniform_int_distribution<std::size_t> dist_;
 
-  std::vector<std::tuple<std::vector<TestResult>, std::vector<TestResult>, std::vector<TestResult>>> test_results_;
+  std::vector<std::vector<std::vector<TestResult>>> test_results_;
+  std::vector<std::vector<std::vector<TestResult>>> async_time_results_;
+  std::vector<std::vector<std::vector<TestResult>>> async_latency_results_;
+};
+
+// measure the time to restart every list in ListTypes from a snapshot file
+// as a function of key count: 10, 100, ... up to max_key_num
+template <typename... ListTypes> class StartupTester {
+ public:
+  StartupTester(const std::size_t& max_key_num,
+                const std::size_t& thread_num,
+                const std::string& snapshot_path)
+    : thread_num_(thread_num),
+      snapshot_path_(snapshot_path) {
+    for (std::size_t key_num(10); key_num < max_key_num; key_num *= 10) {
+      key_nums_.push_back(key_num);
+    }
+    key_nums_.push_back(max_key_num);
+    test_results_.resize(key_nums_.size());
+  }
+
+  void Test(void) {
+    for (std::size_t i = 0; i < key_nums_.size(); i++) {
+      debug_clog << "*** Startup: " << key_nums_.at(i) << " key(s) test begins ***\n";
+      std::vector<int> keys(key_nums_.at(i));
+      for (std::size_t k = 0; k < keys.size(); k++) {
+        keys.at(k) = static_cast<int>(k * 2);
+      }
+      int expand[] = {0, (RunStartupTest<ListTypes>(keys, test_results_.at(i)), 0)...};
+      static_cast<void>(expand);
+    }
+    std::remove(snapshot_path_.c_str());
+  }
+
+  std::string ResultToString(void) {
+    std::stringstream out_stream;
+    std::vector<std::string> names = {UnitTester<ListTypes>::GetName()...};
+
+    // parameter
+    out_stream << "startup: Load Thread Number: " << thread_num_
+               << ", Time Unit: Nanosecond" << std::endl;
+
+    // header
+    out_stream << "KeyNumber";
+    for (auto& name : names) {
+      out_stream << ", " << name;
+    }
+    out_stream << std::endl;
+
+    // line
+    for (std::size_t i = 0; i < key_nums_.size(); i++) {
+      out_stream << key_nums_.at(i);
+      for (auto& result : test_results_.at(i)) {
+        out_stream << ", " << result.count();
+      }
+      out_stream << std::endl;
+    }
+
+    return out_stream.str();
+  }
+
+ private:
+  template <typename ListType>
+  void RunStartupTest(const std::vector<int>& keys, std::vector<TestResult>& results) {
+    {
+      ListType origin(keys.begin(), keys.end(), thread_num_);
+      DumpQuiescentSnapshot(origin, snapshot_path_);
+    }
+
+    // time from an empty list to a fully loaded one, destruction excluded
+    ListType restarted;
+    auto begin = std::chrono::steady_clock::now();
+    LoadSnapshot(restarted, snapshot_path_, thread_num_);
+    auto end = std::chrono::steady_clock::now();
+
+    debug_clog << "--- [" << ListType::name_ << "] Keys = " << keys.size() << ", Load Time = "
+               << std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()
+               << " (ns) ---" << std::endl;
+
+    results.push_back(end - begin);
+  }
+
+  std::size_t thread_num_;
+  std::string snapshot_path_;
+  std::vector<std::size_t> key_nums_;
+  std::vector<std::vector<TestResult>> test_results_;
+};
+
+// run every list in ListTypes under randomized high-contention schedules,
+// record each run and check that it is linearizable
+template <typename... ListTypes> class StressTester {
+ public:
+  // replay: run every round with replay_seed and exactly max_thread_num
+  // threads, only on the list named list_name if it is not empty
+  StressTester(const std::size_t& max_thread_num,
+               const std::size_t& operation_num,
+               const std::size_t& round_num,
+               const int& max_key,
+               const bool& replay = false,
+               const unsigned& replay_seed = 0,
+               const std::string& list_name = "")
+    : max_thread_num_(replay ? std::max<std::size_t>(1, max_thread_num)
+                             : std::max<std::size_t>(2, max_thread_num)),
+      operation_num_(operation_num),
+      round_num_(round_num),
+      max_key_(max_key),
+      replay_(replay),
+      replay_seed_(replay_seed),
+      list_name_(list_name),
+      violation_nums_(sizeof...(ListTypes)) {
+    std::vector<std::string> names = {UnitTester<ListTypes>::GetName()...};
+    if (!list_name_.empty() && std::find(names.begin(), names.end(), list_name_) == names.end()) {
+      throw std::invalid_argument("unknown linked list " + list_name_);
+    }
+  }
+
+  // return the number of violations found
+  std::size_t Test(void) {
+    std::random_device seed_device;
+    for (std::size_t r = 0; r < round_num_; r++) {
+      unsigned seed(replay_ ? replay_seed_ : seed_device());
+      std::size_t thread_num(replay_ ? max_thread_num_ : 2 + r % (max_thread_num_ - 1));
+      debug_clog << "*** Stress: round " << r << ", seed " << seed << ", "
+                 << thread_num << " thread(s) ***\n";
+      std::size_t list_index(0);
+      int expand[] = {0, (RunStressTest<ListTypes>(seed, thread_num, violation_nums_.at(list_index)), ++list_index, 0)...};
+      static_cast<void>(expand);
+    }
+
+    std::size_t total(0);
+    for (auto violation_num : violation_nums_) {
+      total += violation_num;
+    }
+    return total;
+  }
+
+  std::string ResultToString(void) {
+    std::stringstream out_stream;
+    std::vector<std::string> names = {UnitTester<ListTypes>::GetName()...};
+
+    // parameter
+    if (replay_) {
+      out_stream << "stress replay: Seed: " << replay_seed_
+                 << ", Thread Number: " << max_thread_num_;
+    } else {
+      out_stream << "stress: Thread Number: 2 ~ " << max_thread_num_;
+    }
+    out_stream << ", Operation Number: " << operation_num_
+               << ", Rounds: " << round_num_
+               << ", Key Space: 0 ~ " << max_key_
+               << std::endl;
+
+    // line
+    for (std::size_t i = 0; i < names.size(); i++) {
+      if (list_name_.empty() || list_name_ == names.at(i)) {
+        out_stream << names.at(i) << ", " << violation_nums_.at(i) << " violation(s)" << std::endl;
+      }
+    }
+
+    out_stream << reports_.str();
+    return out_stream.str();
+  }
+
+ private:
+  template <typename ListType>
+  void RunStressTest(const unsigned& seed, const std::size_t& thread_num, std::size_t& violation_num) {
+    if (!list_name_.empty() && list_name_ != UnitTester<ListType>::GetName()) {
+      return;
+    }
+
+    // the operations and the random delays only depend on seed
+    std::mt19937 random_engine(seed);
+    std::uniform_int_distribution<int> type_dist(Search, Delete);
+    std::uniform_int_distribution<int> key_dist(0, max_key_);
+    std::vector<std::vector<TestOperation>> operation_list_group(thread_num);
+    for (std::size_t i = 0; i < operation_num_; i++) {
+      operation_list_group.at(i % thread_num).push_back(
+          {static_cast<OperationType>(type_dist(random_engine)), key_dist(random_engine)});
+    }
+
+    ListType linked_list;
+    HistoryRecorder recorder(thread_num, operation_num_ / thread_num + 1);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> thread_pool;
+    for (std::size_t id(0); id < thread_num; id++) {
+      thread_pool.emplace_back([&, id] {
+        std::mt19937 delay_engine(seed + id);
+        std::uniform_int_distribution<int> delay_dist(0, 15);
+        while (!go.load()) {}
+        for (auto& operation : operation_list_group.at(id)) {
+          // perturb the schedule: sometimes yield, sometimes spin
+          int delay(delay_dist(delay_engine));
+          if (delay == 0) {
+            std::this_thread::yield();
+          } else if (delay == 1) {
+            for (volatile int spin = 0; spin < 256; spin = spin + 1) {}
+          }
+          recorder.Invoke(linked_list, id, operation.type_, operation.parameter_);
+        }
+      });
+    }
+    go.store(true);
+    for (auto& thread : thread_pool) {
+      thread.join();
+    }
+
+    std::vector<Violation> violations(LinearizabilityChecker().Check(recorder.Collect()));
+    violation_num += violations.size();
+    for (auto& violation : violations) {
+      reports_ << "--- [" << ListType::name_ << "] seed " << seed
+               << ", " << thread_num << " thread(s), replay: stress_linked_list "
+               << thread_num << " " << operation_num_ << " 1 " << max_key_ << " "
+               << seed << " " << ListType::name_ << " ---\n"
+               << violation.ToString();
+    }
+  }
+
+  std::size_t max_thread_num_;
+  std::size_t operation_num_;
+  std::size_t round_num_;
+  int max_key_;
+  bool replay_;
+  unsigned replay_seed_;
+  std::string list_name_;
+  std::vector<std::size_t> violation_nums_;
+  std::stringstream reports_;
 };
 
 } // namespace utils